@@ -10,13 +10,35 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <map>
+#include <array>
 #include <fstream>
 #include <memory>
 #include <fstream>
+#include <functional>
 #include <exception>
 #include <sstream>
 #include <type_traits>
+#include <set>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <future>
+#include <mutex>
+#include <sys/stat.h>
 
+#ifdef QUICK_PREFERENCES_ZLIB
+#include <zlib.h>
+#endif
+#ifdef QUICK_PREFERENCES_ZSTD
+#include <zstd.h>
+#endif
+
+#ifndef QUICK_PREFERENCES_NO_GUI
 #include <QWidget>
 #include <QGridLayout>
 #include <QLabel>
@@ -26,9 +48,308 @@
 #include <QObject>
 #include <QPushButton>
 #include <QGroupBox>
+#include <QToolButton>
+#include <QTimer>
+#include <QPlainTextEdit>
+#endif
 
 class QuickPreferences {
 
+public:
+	/*!
+	* \brief Computes a FNV-1a hash of a key, usable at compile time
+	* \param The key
+	* \return The hash
+	*/
+	static constexpr uint64_t keyHash(const char* key, uint64_t hash = 14695981039346656037ull) {
+		return *key ? keyHash(key + 1, (hash ^ uint8_t(*key)) * 1099511628211ull) : hash;
+	}
+
+	/*!
+	* \brief Computes a FNV-1a hash of a key, the same as the compile time version
+	* \param The key
+	* \return The hash
+	*/
+	static uint64_t keyHash(const std::string& key) {
+		uint64_t hash = 14695981039346656037ull;
+		for (char letter : key)
+			hash = (hash ^ uint8_t(letter)) * 1099511628211ull;
+		return hash;
+	}
+
+	/*!
+	* \brief Key of a JSON object, copies of an interned key share one string and are compared by identity
+	*
+	* \note Keys constructed from strings are not interned, KeyTable::intern() has to be used for that
+	* \note The hash is computed only once, when the key is created
+	*/
+	class JSONkey {
+		struct Shared {
+			std::atomic<unsigned int> references; // Zero for borrowed keys that exist only during a lookup
+			uint64_t hash;
+			const std::string* text;
+			std::string storage;
+
+			Shared(const std::string& from, unsigned int startReferences) : Shared(from, startReferences, keyHash(from)) {}
+			Shared(const std::string& from, unsigned int startReferences, uint64_t precomputed) :
+					references(startReferences), hash(precomputed), text(&storage) {
+				if (startReferences)
+					storage = from;
+				else
+					text = &from;
+			}
+		};
+		Shared* shared_;
+
+		JSONkey(Shared* shared) : shared_(shared) {}
+		static Shared* share(Shared* shared) {
+			if (shared->references == 0)
+				return new Shared(*shared->text, 1);
+			shared->references++;
+			return shared;
+		}
+
+	public:
+		JSONkey(const std::string& text) : shared_(new Shared(text, 1)) {}
+		JSONkey(const char* text) : shared_(new Shared(std::string(text), 1)) {}
+		JSONkey(const std::string& text, uint64_t hash) : shared_(new Shared(text, 1, hash)) {} // The hash must be keyHash(text)
+		JSONkey(const JSONkey& other) : shared_(share(other.shared_)) {}
+		JSONkey(JSONkey&& other) : shared_(other.shared_->references ? other.shared_ : share(other.shared_)) {
+			if (shared_ == other.shared_)
+				other.shared_ = nullptr;
+		}
+		JSONkey& operator=(JSONkey other) {
+			std::swap(shared_, other.shared_);
+			return *this;
+		}
+		~JSONkey() {
+			if (shared_ && shared_->references && --shared_->references == 0)
+				delete shared_;
+		}
+
+		inline const std::string& str() const {
+			return *shared_->text;
+		}
+		inline operator const std::string&() const {
+			return *shared_->text;
+		}
+		inline uint64_t hash() const {
+			return shared_->hash;
+		}
+		inline const void* identity() const {
+			return shared_;
+		}
+		inline size_t memoryUsage() const {
+			return sizeof(Shared) + stringHeap(shared_->storage);
+		}
+		inline bool operator==(const JSONkey& other) const {
+			return shared_ == other.shared_ || (shared_->hash == other.shared_->hash && *shared_->text == *other.shared_->text);
+		}
+		inline bool operator!=(const JSONkey& other) const {
+			return !(*this == other);
+		}
+
+		struct Hasher {
+			inline size_t operator()(const JSONkey& key) const {
+				return size_t(key.hash());
+			}
+		};
+
+		class Borrowed;
+	};
+
+	/*!
+	* \brief A key referring to a string owned by someone else, for looking up without allocations
+	*
+	* \note Copies of its key() are independent, so they can be stored
+	*/
+	class JSONkey::Borrowed {
+		Shared shared_;
+		JSONkey key_;
+	public:
+		Borrowed(const std::string& text) : shared_(text, 0), key_(&shared_) {}
+		Borrowed(const std::string& text, uint64_t hash) : shared_(text, 0, hash), key_(&shared_) {}
+		Borrowed(const Borrowed&) = delete;
+		inline const JSONkey& key() const {
+			return key_;
+		}
+	};
+
+	/*!
+	* \brief Interns keys of a document, so that each distinct key is stored only once
+	*
+	* \note The keys remain valid after the table is destroyed
+	*/
+	class KeyTable {
+		std::unordered_set<JSONkey, JSONkey::Hasher> keys_;
+	public:
+		JSONkey intern(const std::string& text) {
+			JSONkey::Borrowed lookup(text);
+			return *keys_.insert(lookup.key()).first;
+		}
+		JSONkey intern(const JSONkey& key) {
+			return *keys_.insert(key).first;
+		}
+	};
+
+private:
+	// Compressed files are written through a stream buffer that compresses a block at a time
+	class CompressingBuffer : public std::streambuf {
+	protected:
+		std::ostream& target_;
+		std::vector<char> input_;
+		std::vector<char> output_;
+		virtual void compress(const char* data, size_t size, bool finish) = 0;
+
+		int overflow(int letter) override {
+			compress(pbase(), size_t(pptr() - pbase()), false);
+			setp(input_.data(), input_.data() + input_.size());
+			if (letter != traits_type::eof()) {
+				*pptr() = char(letter);
+				pbump(1);
+			}
+			return traits_type::not_eof(letter);
+		}
+	public:
+		CompressingBuffer(std::ostream& target) : target_(target), input_(1 << 16), output_(1 << 16) {
+			setp(input_.data(), input_.data() + input_.size());
+		}
+		inline size_t memoryUsage() const {
+			return input_.capacity() + output_.capacity();
+		}
+		void finish() {
+			compress(pbase(), size_t(pptr() - pbase()), true);
+			setp(input_.data(), input_.data() + input_.size());
+			if (!target_.good()) throw(std::runtime_error("Could not write the compressed file"));
+		}
+		virtual ~CompressingBuffer() = default;
+	};
+
+	static bool endsWith(const std::string& text, const char* suffix) {
+		size_t length = strlen(suffix);
+		return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+	}
+
+#ifdef QUICK_PREFERENCES_ZLIB
+	class GzipBuffer : public CompressingBuffer {
+		z_stream stream_;
+		void compress(const char* data, size_t size, bool finish) override {
+			stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+			stream_.avail_in = uInt(size);
+			int result;
+			do {
+				stream_.next_out = reinterpret_cast<Bytef*>(output_.data());
+				stream_.avail_out = uInt(output_.size());
+				result = deflate(&stream_, finish ? Z_FINISH : Z_NO_FLUSH);
+				if (result == Z_STREAM_ERROR) throw(std::runtime_error("Gzip compression failed"));
+				target_.write(output_.data(), std::streamsize(output_.size() - stream_.avail_out));
+			} while (stream_.avail_out == 0 || (finish && result != Z_STREAM_END));
+		}
+	public:
+		GzipBuffer(std::ostream& target, int level = Z_DEFAULT_COMPRESSION) : CompressingBuffer(target) {
+			memset(&stream_, 0, sizeof(stream_));
+			if (deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw(std::runtime_error("Could not initialise gzip compression"));
+		}
+		~GzipBuffer() {
+			deflateEnd(&stream_);
+		}
+	};
+
+	static void readGzip(std::istream& in, std::string& into) {
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		// Concatenated gzip members are allowed, each one is decompressed in turn
+		if (inflateInit2(&stream, 15 + 32) != Z_OK)
+			throw(std::runtime_error("Could not initialise gzip decompression"));
+		std::vector<char> input(1 << 16);
+		size_t written = 0;
+		int result = Z_OK;
+		while (in.read(input.data(), std::streamsize(input.size())) || in.gcount() > 0) {
+			stream.next_in = reinterpret_cast<Bytef*>(input.data());
+			stream.avail_in = uInt(in.gcount());
+			while (stream.avail_in > 0) {
+				if (result == Z_STREAM_END)
+					inflateReset(&stream);
+				if (into.size() - written < input.size())
+					into.resize(std::max(into.size() * 2, written + input.size()));
+				stream.next_out = reinterpret_cast<Bytef*>(&into[written]);
+				stream.avail_out = uInt(into.size() - written);
+				result = inflate(&stream, Z_NO_FLUSH);
+				written = into.size() - stream.avail_out;
+				if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+					inflateEnd(&stream);
+					throw(std::runtime_error("Corrupted gzip file"));
+				}
+			}
+		}
+		// Output still held by zlib is collected, the file is truncated if the stream didn't end
+		while (result == Z_OK) {
+			if (into.size() - written < input.size())
+				into.resize(std::max(into.size() * 2, written + input.size()));
+			stream.next_out = reinterpret_cast<Bytef*>(&into[written]);
+			stream.avail_out = uInt(into.size() - written);
+			result = inflate(&stream, Z_NO_FLUSH);
+			written = into.size() - stream.avail_out;
+		}
+		inflateEnd(&stream);
+		if (result != Z_STREAM_END)
+			throw(std::runtime_error("Truncated or corrupted gzip file"));
+		into.resize(written);
+	}
+#endif
+
+#ifdef QUICK_PREFERENCES_ZSTD
+	class ZstdBuffer : public CompressingBuffer {
+		ZSTD_CStream* stream_;
+		void compress(const char* data, size_t size, bool finish) override {
+			ZSTD_inBuffer in = { data, size, 0 };
+			size_t remaining;
+			do {
+				ZSTD_outBuffer out = { output_.data(), output_.size(), 0 };
+				remaining = ZSTD_compressStream2(stream_, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+				if (ZSTD_isError(remaining)) throw(std::runtime_error(std::string("Zstd compression failed: ") + ZSTD_getErrorName(remaining)));
+				target_.write(output_.data(), std::streamsize(out.pos));
+			} while (finish ? remaining != 0 : in.pos < in.size);
+		}
+	public:
+		ZstdBuffer(std::ostream& target, int level = 3) : CompressingBuffer(target), stream_(ZSTD_createCStream()) {
+			if (!stream_ || ZSTD_isError(ZSTD_initCStream(stream_, level)))
+				throw(std::runtime_error("Could not initialise zstd compression"));
+		}
+		~ZstdBuffer() {
+			ZSTD_freeCStream(stream_);
+		}
+	};
+
+	static void readZstd(std::istream& in, std::string& into) {
+		std::unique_ptr<ZSTD_DStream, size_t(*)(ZSTD_DStream*)> stream(ZSTD_createDStream(), &ZSTD_freeDStream);
+		if (!stream || ZSTD_isError(ZSTD_initDStream(stream.get())))
+			throw(std::runtime_error("Could not initialise zstd decompression"));
+		std::vector<char> input(ZSTD_DStreamInSize());
+		size_t written = 0;
+		size_t result = 0;
+		while (in.read(input.data(), std::streamsize(input.size())) || in.gcount() > 0) {
+			ZSTD_inBuffer inBuffer = { input.data(), size_t(in.gcount()), 0 };
+			// A full output buffer means that zstd may still hold some output
+			bool full = true;
+			while (inBuffer.pos < inBuffer.size || full) {
+				if (into.size() - written < ZSTD_DStreamOutSize())
+					into.resize(std::max(into.size() * 2, written + ZSTD_DStreamOutSize()));
+				ZSTD_outBuffer outBuffer = { &into[written], into.size() - written, 0 };
+				result = ZSTD_decompressStream(stream.get(), &outBuffer, &inBuffer);
+				if (ZSTD_isError(result)) throw(std::runtime_error(std::string("Corrupted zstd file: ") + ZSTD_getErrorName(result)));
+				written += outBuffer.pos;
+				full = (outBuffer.pos == outBuffer.size);
+			}
+		}
+		// Zero means that the last frame was complete
+		if (result != 0)
+			throw(std::runtime_error("Truncated zstd file"));
+		into.resize(written);
+	}
+#endif
+
 public:
 	enum class JSONtype : uint8_t {
 		NIL,
@@ -38,6 +359,220 @@ public:
 		ARRAY,
 		OBJECT
 	};
+
+	/*!
+	* \brief Memory used by a JSON structure or by preferences objects, in bytes
+	*
+	* \note The sizes are computed from the data structures, the allocator's own overhead is not included
+	*/
+	struct MemoryUsage {
+		size_t nodes = 0; // JSON nodes with their reference counts
+		size_t containers = 0; // Storage of vectors and entries and buckets of maps, including arrays of numbers stored in bulk
+		size_t strings = 0; // Characters of strings that don't fit into the string itself
+		size_t keys = 0; // Keys of JSON objects, each interned key is counted once
+		size_t objects = 0; // Objects derived from QuickPreferences and values held through pointers
+		size_t buffers = 0; // Text being parsed or written, only in lastPeakMemory()
+		size_t nodeCounts[int(JSONtype::OBJECT) + 1] = {};
+
+		inline size_t count(JSONtype type) const {
+			return nodeCounts[int(type)];
+		}
+		inline size_t total() const {
+			return nodes + containers + strings + keys + objects + buffers;
+		}
+	};
+
+	/*!
+	* \brief Remembers the state of a file when it was last loaded, so that loading it again can be skipped if it didn't change
+	*/
+	struct FileStamp {
+		bool valid = false;
+		uint64_t size = 0;
+		int64_t modifiedSeconds = 0;
+		int64_t modifiedNanoseconds = 0;
+		uint64_t inode = 0;
+		uint64_t hash = 0; // Of the contents, after decompression
+
+		/*!
+		* \brief Reads the metadata of a file
+		* \param The name of the file
+		* \return false if the file doesn't exist
+		*/
+		bool read(const std::string& fileName) {
+#ifdef _WIN32
+			struct _stat64 status;
+			if (_stat64(fileName.c_str(), &status) != 0)
+				return false;
+			modifiedNanoseconds = 0;
+#else
+			struct stat status;
+			if (stat(fileName.c_str(), &status) != 0)
+				return false;
+#ifdef __APPLE__
+			modifiedNanoseconds = status.st_mtimespec.tv_nsec;
+#else
+			modifiedNanoseconds = status.st_mtim.tv_nsec;
+#endif
+#endif
+			size = uint64_t(status.st_size);
+			modifiedSeconds = int64_t(status.st_mtime);
+			inode = uint64_t(status.st_ino);
+			return true;
+		}
+		bool sameFile(const FileStamp& other) const {
+			return valid && other.size == size && other.modifiedSeconds == modifiedSeconds
+					&& other.modifiedNanoseconds == modifiedNanoseconds && other.inode == inode;
+		}
+	};
+
+	struct JSON;
+
+private:
+	struct MemoryCounter {
+		MemoryUsage usage;
+		std::unordered_set<const void*> counted;
+
+		void addNode(JSONtype type, size_t size) {
+			// The node lives in the same allocation as the reference counts if created by std::make_shared
+			usage.nodes += size + sizeof(void*) + 2 * sizeof(int);
+			usage.nodeCounts[int(type)]++;
+		}
+		void addChild(const std::shared_ptr<JSON>& child) {
+			if (child.use_count() == 1 || counted.insert(child.get()).second)
+				child->measure(*this);
+		}
+		void addKey(const JSONkey& key) {
+			if (counted.insert(key.identity()).second)
+				usage.keys += key.memoryUsage();
+		}
+	};
+
+public:
+	/*!
+	* \brief Appends JSON text to a buffer, if it has a stream, the buffer is moved into it whenever it grows large
+	*
+	* \note Strings are copied in runs of characters that need no escaping, which are found using a table
+	* \note Control characters, quotes, backslashes and the line separators U+2028 and U+2029 are escaped
+	*/
+	class JSONwriter {
+		std::string& buffer_;
+		std::ostream* stream_;
+		static const size_t flushSize = 1 << 16;
+
+		// The letter after the backslash, u for characters written as \u00XX, U for the first byte of U+2028 and U+2029
+		static const char* escapes() {
+			static const std::array<char, 256> table = [] () {
+				std::array<char, 256> made;
+				made.fill(0);
+				for (int i = 0; i < 0x20; i++)
+					made[i] = 'u';
+				made['"'] = '"';
+				made['\\'] = '\\';
+				made['\n'] = 'n';
+				made['\t'] = 't';
+				made['\r'] = 'r';
+				made['\b'] = 'b';
+				made['\f'] = 'f';
+				made[0xe2] = 'U';
+				return made;
+			}();
+			return table.data();
+		}
+
+	public:
+		JSONwriter(std::string& buffer, std::ostream* stream = nullptr) : buffer_(buffer), stream_(stream) {}
+
+		inline void put(char letter) {
+			buffer_.push_back(letter);
+		}
+		inline void append(const char* text, size_t size) {
+			buffer_.append(text, size);
+		}
+		void indent(int depth) {
+			static const std::string tabs(32, '\t');
+			for (; depth > int(tabs.size()); depth -= int(tabs.size()))
+				buffer_.append(tabs);
+			if (depth > 0)
+				buffer_.append(tabs.data(), size_t(depth));
+		}
+		void writeString(const char* text, size_t size) {
+			static const char digits[] = "0123456789abcdef";
+			const char* table = escapes();
+			buffer_.push_back('"');
+			size_t copied = 0;
+			for (size_t i = 0; i < size; i++) {
+				char escape = table[uint8_t(text[i])];
+				if (!escape)
+					continue;
+				if (escape == 'U' && (i + 2 >= size || uint8_t(text[i + 1]) != 0x80 || (uint8_t(text[i + 2]) & 0xfe) != 0xa8))
+					continue;
+				buffer_.append(text + copied, i - copied);
+				if (escape == 'u') {
+					const char code[] = { '\\', 'u', '0', '0', digits[uint8_t(text[i]) >> 4], digits[uint8_t(text[i]) & 0xf] };
+					buffer_.append(code, sizeof(code));
+				} else if (escape == 'U') {
+					buffer_.append((uint8_t(text[i + 2]) == 0xa8) ? "\\u2028" : "\\u2029", 6);
+					i += 2;
+				} else {
+					buffer_.push_back('\\');
+					buffer_.push_back(escape);
+				}
+				copied = i + 1;
+			}
+			buffer_.append(text + copied, size - copied);
+			buffer_.push_back('"');
+		}
+		void writeNumber(double value) {
+			if (!std::isfinite(value)) {
+				buffer_.append("null", 4);
+				return;
+			}
+			// Integers are written without the C library, which is slower and depends on locale
+			if (value == std::floor(value) && std::fabs(value) < 1e15) {
+				char digits[24];
+				int position = sizeof(digits);
+				uint64_t magnitude = uint64_t(std::fabs(value));
+				do {
+					digits[--position] = char('0' + magnitude % 10);
+					magnitude /= 10;
+				} while (magnitude);
+				if (value < 0)
+					digits[--position] = '-';
+				buffer_.append(digits + position, sizeof(digits) - position);
+				return;
+			}
+			// The shortest precision that reads back as the same number
+			char text[32];
+			for (int precision : { 15, 16, 17 }) {
+				int length = snprintf(text, sizeof(text), "%.*g", precision, value);
+				for (int i = 0; i < length; i++)
+					if (text[i] == ',')
+						text[i] = '.';
+				if (precision == 17 || JSONparser::parseNumber(text, text + length) == value) {
+					buffer_.append(text, size_t(length));
+					return;
+				}
+			}
+		}
+
+		/*!
+		* \brief Moves the buffer into the stream if it's large
+		*/
+		inline void checkpoint() {
+			if (stream_ && buffer_.size() >= flushSize)
+				flush();
+		}
+		/*!
+		* \brief Moves the buffer into the stream
+		*/
+		void flush() {
+			if (!stream_)
+				return;
+			stream_->write(buffer_.data(), std::streamsize(buffer_.size()));
+			buffer_.clear();
+		}
+	};
+
 	struct JSON {
 		inline virtual JSONtype type() {
 			return JSONtype::NIL;
@@ -45,6 +580,9 @@ public:
 		inline virtual std::string& getString() {
 			throw(std::runtime_error("String value is not really string"));
 		}
+		inline virtual void copyString(std::string& into) {
+			into = getString();
+		}
 		inline virtual double& getDouble() {
 			throw(std::runtime_error("Double value is not really double"));
 		}
@@ -54,41 +592,85 @@ public:
 		inline virtual std::vector<std::shared_ptr<JSON>>& getVector() {
 			throw(std::runtime_error("Array value is not really array"));
 		}
-		inline virtual std::unordered_map<std::string, std::shared_ptr<JSON>>& getObject() {
+		inline virtual std::vector<double>& getNumbers() {
+			throw(std::runtime_error("Array value is not really array of numbers"));
+		}
+		inline virtual std::unordered_map<JSONkey, std::shared_ptr<JSON>, JSONkey::Hasher>& getObject() {
 			throw(std::runtime_error("Object value is not really an object"));
 		}
-		inline virtual void write(std::ostream& out, int = 0) {
-			out << "null";
+		inline virtual JSON* findMember(const std::string& key) {
+			JSONkey::Borrowed lookup(key);
+			return findKey(lookup.key());
+		}
+		// If documentKey is given, it's replaced by the key stored in the object, so that the next lookup compares them by identity
+		inline virtual JSON* findKey(const JSONkey& key, JSONkey* documentKey = nullptr) {
+			auto& contents = getObject();
+			auto found = contents.find(key);
+			if (found == contents.end())
+				return nullptr;
+			if (documentKey && documentKey->identity() != found->first.identity())
+				*documentKey = found->first;
+			return found->second.get();
+		}
+		inline virtual std::shared_ptr<JSON>& memberSlot(const std::string& key, KeyTable* keys = nullptr) {
+			if (keys)
+				return getObject()[keys->intern(key)];
+			return getObject()[JSONkey(key)];
+		}
+		inline virtual std::shared_ptr<JSON>& keySlot(const JSONkey& key, KeyTable* keys = nullptr) {
+			if (keys)
+				return getObject()[keys->intern(key)];
+			return getObject()[key];
 		}
-		inline void writeToFile(const std::string& fileName) {
-			std::ofstream out(fileName);
+		inline virtual void write(JSONwriter& out, int = 0) {
+			out.append("null", 4);
+		}
+		// Returns the size of the buffer used for writing
+		inline size_t write(std::ostream& out, int depth = 0) {
+			std::string buffer;
+			JSONwriter writer(buffer, &out);
+			write(writer, depth);
+			writer.flush();
+			return buffer.capacity();
+		}
+		inline virtual void measure(MemoryCounter& counter) {
+			counter.addNode(JSONtype::NIL, sizeof(JSON));
+		}
+		// Returns the size of the buffers used for writing and compressing
+		inline size_t writeToFile(const std::string& fileName) {
+			std::unique_ptr<CompressingBuffer> compressor;
+			bool compressed = false;
+#ifdef QUICK_PREFERENCES_ZLIB
+			compressed = compressed || endsWith(fileName, ".gz");
+#endif
+#ifdef QUICK_PREFERENCES_ZSTD
+			compressed = compressed || endsWith(fileName, ".zst");
+#endif
+			std::ofstream out(fileName, compressed ? std::ios::out | std::ios::binary : std::ios::out);
 			if (!out.good()) throw(std::runtime_error("Could not write to file " + fileName));
-			this->write(out, 0);
+#ifdef QUICK_PREFERENCES_ZLIB
+			if (endsWith(fileName, ".gz"))
+				compressor.reset(new GzipBuffer(out));
+#endif
+#ifdef QUICK_PREFERENCES_ZSTD
+			if (endsWith(fileName, ".zst"))
+				compressor.reset(new ZstdBuffer(out));
+#endif
+			if (compressor) {
+				std::ostream compressing(compressor.get());
+				// Compression errors are thrown by the stream buffer, the stream would only remember them otherwise
+				compressing.exceptions(std::ios::badbit);
+				size_t buffers = write(compressing, 0) + compressor->memoryUsage();
+				compressor->finish();
+				return buffers;
+			}
+			size_t buffers = write(out, 0);
+			out.flush();
+			if (!out.good()) throw(std::runtime_error("Could not write to file " + fileName));
+			return buffers;
 		}
 
 		virtual ~JSON() = default;
-	protected:
-		static void writeString(std::ostream& out, const std::string& written) {
-			out.put('"');
-			for (unsigned int i = 0; i < written.size(); i++) {
-				if (written[i] == '"') {
-					out.put('/');
-					out.put('"');
-				} else if (written[i] == '\n') {
-					out.put('\\');
-					out.put('n');
-				} else if (written[i] == '\\') {
-					out.put('\\');
-					out.put('\\');
-				} else
-					out.put(written[i]);
-			}
-			out.put('"');
-		}
-		static void indent(std::ostream& out, int depth) {
-			for (int i = 0; i < depth; i++)
-				out.put('\t');
-		}
 	};
 	struct JSONstring : public JSON {
 		std::string contents_;
@@ -100,8 +682,48 @@ public:
 		inline virtual std::string& getString() {
 			return contents_;
 		}
-		inline void write(std::ostream& out, int = 0) {
-			writeString(out, contents_);
+		inline virtual void copyString(std::string& into) {
+			into = contents_;
+		}
+		using JSON::write;
+		inline void write(JSONwriter& out, int = 0) {
+			out.writeString(contents_.data(), contents_.size());
+		}
+		inline void measure(MemoryCounter& counter) {
+			counter.addNode(JSONtype::STRING, sizeof(JSONstring));
+			counter.usage.strings += stringHeap(contents_);
+		}
+	};
+	struct JSONstringView : public JSONstring {
+		// Part of a buffer that outlives the node, contents_ is used after getString() is called
+		const char* begin_;
+		size_t size_;
+		JSONstringView(const char* begin, size_t size) : begin_(begin), size_(size) {}
+
+		inline virtual std::string& getString() {
+			if (begin_) {
+				contents_.assign(begin_, size_);
+				begin_ = nullptr;
+			}
+			return contents_;
+		}
+		inline virtual void copyString(std::string& into) {
+			if (begin_)
+				into.assign(begin_, size_);
+			else
+				into = contents_;
+		}
+		using JSON::write;
+		inline void write(JSONwriter& out, int = 0) {
+			if (begin_)
+				out.writeString(begin_, size_);
+			else
+				out.writeString(contents_.data(), contents_.size());
+		}
+		inline void measure(MemoryCounter& counter) {
+			// The viewed characters belong to the buffer
+			counter.addNode(JSONtype::STRING, sizeof(JSONstringView));
+			counter.usage.strings += stringHeap(contents_);
 		}
 	};
 	struct JSONdouble : public JSON {
@@ -114,8 +736,12 @@ public:
 		inline virtual double& getDouble() {
 			return value_;
 		}
-		inline void write(std::ostream& out, int = 0) {
-			out << value_;
+		using JSON::write;
+		inline void write(JSONwriter& out, int = 0) {
+			out.writeNumber(value_);
+		}
+		inline void measure(MemoryCounter& counter) {
+			counter.addNode(JSONtype::NUMBER, sizeof(JSONdouble));
 		}
 	};
 	struct JSONbool : public JSON {
@@ -128,192 +754,1068 @@ public:
 		inline virtual bool& getBool() {
 			return value_;
 		}
-		inline void write(std::ostream& out, int = 0) {
-			out << (value_ ? "true" : "false");
+		using JSON::write;
+		inline void write(JSONwriter& out, int = 0) {
+			if (value_)
+				out.append("true", 4);
+			else
+				out.append("false", 5);
+		}
+		inline void measure(MemoryCounter& counter) {
+			counter.addNode(JSONtype::BOOL, sizeof(JSONbool));
 		}
 	};
 	struct JSONobject : public JSON {
-		std::unordered_map<std::string, std::shared_ptr<JSON>> contents_;
+		std::unordered_map<JSONkey, std::shared_ptr<JSON>, JSONkey::Hasher> contents_;
 		JSONobject() {}
 
 		inline virtual JSONtype type() {
 			return JSONtype::OBJECT;
 		}
-		inline virtual std::unordered_map<std::string, std::shared_ptr<JSON>>& getObject() {
+		inline virtual std::unordered_map<JSONkey, std::shared_ptr<JSON>, JSONkey::Hasher>& getObject() {
 			return contents_;
 		}
-		inline void write(std::ostream& out, int depth = 0) {
+		using JSON::write;
+		inline void write(JSONwriter& out, int depth = 0) {
 			if (contents_.empty()) {
-				out.put('{');
-				out.put('}');
+				out.append("{}", 2);
 				return;
 			}
 			out.put('{');
-			out.put('\n');
 			bool first = true;
 			for (auto& it : contents_) {
-				if (first)
-					first = false;
-				else {
-					out.put(',');
+				if (first) {
 					out.put('\n');
-				}
-				indent(out, depth + 1);
-				writeString(out, it.first);
-				out.put(':');
-				out.put(' ');
+					first = false;
+				} else
+					out.append(",\n", 2);
+				out.indent(depth + 1);
+				const std::string& key = it.first;
+				out.writeString(key.data(), key.size());
+				out.append(": ", 2);
 				it.second->write(out, depth + 1);
+				out.checkpoint();
 			}
 			out.put('\n');
-			indent(out, depth);
+			out.indent(depth);
 			out.put('}');
 		}
+		inline void measure(MemoryCounter& counter) {
+			counter.addNode(JSONtype::OBJECT, sizeof(JSONobject));
+			counter.usage.containers += containerHeap(contents_);
+			for (auto& it : contents_) {
+				counter.addKey(it.first);
+				counter.addChild(it.second);
+			}
+		}
 	};
 	struct JSONarray : public JSON {
+		// Arrays of numbers are kept in numbers_ without a node per element, only one of the vectors is used
 		std::vector<std::shared_ptr<JSON>> contents_;
+		std::vector<double> numbers_;
 		JSONarray() {}
 
 		inline virtual JSONtype type() {
 			return JSONtype::ARRAY;
 		}
 		inline virtual std::vector<std::shared_ptr<JSON>>& getVector() {
+			if (!numbers_.empty()) {
+				contents_.reserve(numbers_.size());
+				for (double number : numbers_)
+					contents_.push_back(std::make_shared<JSONdouble>(number));
+				numbers_.clear();
+			}
 			return contents_;
 		}
-		inline void write(std::ostream& out, int depth = 0) {
+		inline virtual std::vector<double>& getNumbers() {
+			if (!contents_.empty()) {
+				numbers_.reserve(contents_.size());
+				for (auto& it : contents_) {
+					// Non-finite numbers are written as null, so nulls are read back as NaN
+					if (it->type() == JSONtype::NIL)
+						numbers_.push_back(std::numeric_limits<double>::quiet_NaN());
+					else if (it->type() == JSONtype::NUMBER)
+						numbers_.push_back(it->getDouble());
+					else {
+						numbers_.clear();
+						throw(std::runtime_error("Array value is not really array of numbers"));
+					}
+				}
+				contents_.clear();
+			}
+			return numbers_;
+		}
+		using JSON::write;
+		inline void write(JSONwriter& out, int depth = 0) {
 			out.put('[');
+			if (!numbers_.empty()) {
+				for (unsigned int i = 0; i < numbers_.size(); i++) {
+					if (i > 0)
+						out.append(", ", 2);
+					out.writeNumber(numbers_[i]);
+				}
+				out.put(']');
+				out.checkpoint();
+				return;
+			}
 			if (contents_.empty()) {
 				out.put(']');
 				return;
 			}
 			for (auto& it : contents_) {
+				if (&it != &contents_.front())
+					out.put(',');
 				out.put('\n');
-				indent(out, depth);
-				indent(out, depth);
+				out.indent(depth + 1);
 				it->write(out, depth + 1);
+				out.checkpoint();
 			}
 			out.put('\n');
-			indent(out, depth);
+			out.indent(depth);
 			out.put(']');
-			
+		}
+		inline void measure(MemoryCounter& counter) {
+			counter.addNode(JSONtype::ARRAY, sizeof(JSONarray));
+			counter.usage.containers += containerHeap(contents_) + containerHeap(numbers_);
+			for (auto& it : contents_)
+				counter.addChild(it);
 		}
 	};
 
-	static std::shared_ptr<JSON> parseJSON(std::istream& in) {
-		auto readString = [&in] () -> std::string {
-			char letter = char(in.get());
-			std::string collected;
-			while (letter != '"') {
-				if (letter == '\\') {
-					if (in.get() == '"') collected.push_back('"');
-					else if (in.get() == 'n') collected.push_back('\n');
-					else if (in.get() == '\\') collected.push_back('\\');
-				} else {
-					collected.push_back(letter);
+private:
+	// Stands for one element of a vector stored by columns, an array for each key, select() chooses the element
+	struct JSONcolumns : public JSON {
+		JSON* columns_;
+		std::vector<std::pair<std::string, JSONarray*>> order_; // Columns in the order process() used them, to skip looking them up
+		size_t index_ = 0;
+		size_t call_ = 0;
+		JSONdouble number_;
+		JSONcolumns(JSON* columns) : columns_(columns) {}
+
+		void select(size_t index) {
+			index_ = index;
+			call_ = 0;
+		}
+		JSONarray* column(const std::string& key, KeyTable* keys, bool creating) {
+			if (call_ < order_.size() && order_[call_].first == key)
+				return order_[call_++].second;
+			JSONarray* found = nullptr;
+			JSON* existing = columns_->findMember(key);
+			if (existing) {
+				found = dynamic_cast<JSONarray*>(existing);
+				if (!found) throw(std::runtime_error("Column " + key + " is not an array"));
+			} else if (creating) {
+				auto made = std::make_shared<JSONarray>();
+				found = made.get();
+				columns_->memberSlot(key, keys) = made;
+			}
+			if (call_ < order_.size())
+				order_[call_] = std::make_pair(key, found);
+			else
+				order_.emplace_back(key, found);
+			call_++;
+			return found;
+		}
+		inline virtual JSONtype type() {
+			return JSONtype::OBJECT;
+		}
+		inline virtual JSON* findMember(const std::string& key) {
+			JSONarray* found = column(key, nullptr, false);
+			if (!found)
+				return nullptr;
+			if (!found->numbers_.empty()) {
+				if (index_ >= found->numbers_.size()) return nullptr;
+				number_.value_ = found->numbers_[index_];
+				return &number_;
+			}
+			return (index_ < found->contents_.size()) ? found->contents_[index_].get() : nullptr;
+		}
+		inline virtual JSON* findKey(const JSONkey& key, JSONkey* = nullptr) {
+			return findMember(key.str());
+		}
+		inline virtual std::shared_ptr<JSON>& memberSlot(const std::string& key, KeyTable* keys = nullptr) {
+			JSONarray* found = column(key, keys, true);
+			if (found->contents_.size() <= index_)
+				found->contents_.resize(index_ + 1);
+			return found->contents_[index_];
+		}
+		inline virtual std::shared_ptr<JSON>& keySlot(const JSONkey& key, KeyTable* keys = nullptr) {
+			return memberSlot(key.str(), keys);
+		}
+		// Values missing in some elements become nulls, columns of numbers are stored in bulk
+		void finish(size_t count) {
+			for (auto& it : columns_->getObject()) {
+				JSONarray* finished = static_cast<JSONarray*>(it.second.get());
+				finished->contents_.resize(count);
+				bool numbers = true;
+				for (auto& cell : finished->contents_) {
+					if (!cell)
+						cell = std::make_shared<JSON>();
+					numbers = numbers && cell->type() == JSONtype::NUMBER;
+				}
+				if (numbers)
+					finished->getNumbers();
+			}
+		}
+	};
+
+	// An object loaded as a whole, like a map, it replaces the object of a lower layer instead of being merged with it
+	struct JSONwholeObject : public JSONobject {};
+
+	static bool equalJSON(JSON& first, JSON& second) {
+		if (&first == &second)
+			return true;
+		if (first.type() != second.type())
+			return false;
+		switch (first.type()) {
+		case JSONtype::NIL:
+			return true;
+		case JSONtype::STRING:
+			return first.getString() == second.getString();
+		case JSONtype::NUMBER:
+			return first.getDouble() == second.getDouble();
+		case JSONtype::BOOL:
+			return first.getBool() == second.getBool();
+		case JSONtype::ARRAY:
+		{
+			JSONarray& firstArray = static_cast<JSONarray&>(first);
+			JSONarray& secondArray = static_cast<JSONarray&>(second);
+			if (!firstArray.numbers_.empty() && !secondArray.numbers_.empty())
+				return firstArray.numbers_ == secondArray.numbers_;
+			auto& firstElements = firstArray.getVector();
+			auto& secondElements = secondArray.getVector();
+			if (firstElements.size() != secondElements.size())
+				return false;
+			for (unsigned int i = 0; i < firstElements.size(); i++)
+				if (!equalJSON(*firstElements[i], *secondElements[i]))
+					return false;
+			return true;
+		}
+		case JSONtype::OBJECT:
+		{
+			auto& firstContents = first.getObject();
+			auto& secondContents = second.getObject();
+			if (firstContents.size() != secondContents.size())
+				return false;
+			for (auto& it : firstContents) {
+				auto found = secondContents.find(it.first);
+				if (found == secondContents.end() || !equalJSON(*it.second, *found->second))
+					return false;
+			}
+			return true;
+		}
+		}
+		return false;
+	}
+
+	// Returns the values of modified that differ from base, objects are compared key by key, null if nothing differs
+	static std::shared_ptr<JSON> differenceJSON(const std::shared_ptr<JSON>& modified, JSON& base) {
+		if (modified->type() != JSONtype::OBJECT || base.type() != JSONtype::OBJECT || dynamic_cast<JSONwholeObject*>(modified.get()))
+			return equalJSON(*modified, base) ? nullptr : modified;
+		auto& baseContents = base.getObject();
+		std::shared_ptr<JSONobject> difference;
+		for (auto& it : modified->getObject()) {
+			auto found = baseContents.find(it.first);
+			std::shared_ptr<JSON> changed = (found == baseContents.end()) ? it.second : differenceJSON(it.second, *found->second);
+			if (changed) {
+				if (!difference)
+					difference = std::make_shared<JSONobject>();
+				difference->contents_[it.first] = changed;
+			}
+		}
+		return difference;
+	}
+
+	struct JSONparser {
+		const char* position;
+		const char* end;
+		KeyTable& keys;
+		bool borrowStrings;
+
+		// Commas are skipped like whitespace, 0 is returned at the end
+		char next() {
+			while (position != end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r' || *position == ','))
+				position++;
+			return (position != end) ? *position++ : 0;
+		}
+
+		void expectWord(const char* rest, const char* word) {
+			for (; *rest; rest++, position++)
+				if (position == end || *position != *rest)
+					throw(std::runtime_error(std::string("JSON parser found misspelled '") + word + "'"));
+		}
+
+		static void appendUtf8(std::string& to, uint32_t codePoint) {
+			if (codePoint < 0x80)
+				to.push_back(char(codePoint));
+			else if (codePoint < 0x800) {
+				to.push_back(char(0xc0 | (codePoint >> 6)));
+				to.push_back(char(0x80 | (codePoint & 0x3f)));
+			} else if (codePoint < 0x10000) {
+				to.push_back(char(0xe0 | (codePoint >> 12)));
+				to.push_back(char(0x80 | ((codePoint >> 6) & 0x3f)));
+				to.push_back(char(0x80 | (codePoint & 0x3f)));
+			} else {
+				to.push_back(char(0xf0 | (codePoint >> 18)));
+				to.push_back(char(0x80 | ((codePoint >> 12) & 0x3f)));
+				to.push_back(char(0x80 | ((codePoint >> 6) & 0x3f)));
+				to.push_back(char(0x80 | (codePoint & 0x3f)));
+			}
+		}
+
+		uint32_t readHex() {
+			if (end - position < 4)
+				throw(std::runtime_error("JSON parser found an incomplete \\u escape sequence"));
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++) {
+				char letter = *position++;
+				value <<= 4;
+				if (letter >= '0' && letter <= '9') value |= uint32_t(letter - '0');
+				else if (letter >= 'a' && letter <= 'f') value |= uint32_t(letter - 'a' + 10);
+				else if (letter >= 'A' && letter <= 'F') value |= uint32_t(letter - 'A' + 10);
+				else throw(std::runtime_error("JSON parser found an invalid \\u escape sequence"));
+			}
+			return value;
+		}
+
+		// Reads a string after its opening quote, returns false if it's in decoded, true if it can be used directly from the buffer
+		bool readString(const char*& begin, size_t& size, std::string& decoded) {
+			begin = position;
+			while (position != end && *position != '"' && *position != '\\')
+				position++;
+			if (position == end)
+				throw(std::runtime_error("JSON parser found an unterminated string"));
+			if (*position == '"') {
+				size = size_t(position - begin);
+				position++;
+				return true;
+			}
+			decoded.assign(begin, position);
+			while (true) {
+				if (position == end)
+					throw(std::runtime_error("JSON parser found an unterminated string"));
+				char letter = *position++;
+				if (letter == '"')
+					return false;
+				if (letter != '\\') {
+					decoded.push_back(letter);
+					continue;
+				}
+				if (position == end)
+					throw(std::runtime_error("JSON parser found an unterminated string"));
+				letter = *position++;
+				switch (letter) {
+				case 'n': decoded.push_back('\n'); break;
+				case 't': decoded.push_back('\t'); break;
+				case 'r': decoded.push_back('\r'); break;
+				case 'b': decoded.push_back('\b'); break;
+				case 'f': decoded.push_back('\f'); break;
+				case 'u':
+				{
+					uint32_t codePoint = readHex();
+					if (codePoint >= 0xd800 && codePoint < 0xdc00 && end - position >= 6 && position[0] == '\\' && position[1] == 'u') {
+						position += 2;
+						uint32_t low = readHex();
+						if (low >= 0xdc00 && low < 0xe000)
+							codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+						else {
+							appendUtf8(decoded, codePoint);
+							codePoint = low;
+						}
+					}
+					appendUtf8(decoded, codePoint);
+					break;
+				}
+				default: decoded.push_back(letter); // Quotes, slashes and backslashes
+				}
+			}
+		}
+
+		static double parseNumber(const char* begin, const char* end) {
+			static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+					1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+			// Numbers with at most 15 significant digits and a small exponent are computed exactly without locale dependent functions
+			const char* at = begin;
+			bool negative = (at != end && *at == '-');
+			if (negative) at++;
+			uint64_t mantissa = 0;
+			int significant = 0;
+			int exponent = 0;
+			for (; at != end && *at >= '0' && *at <= '9'; at++) {
+				mantissa = mantissa * 10 + uint64_t(*at - '0');
+				if (mantissa) significant++;
+				if (significant > 15) break;
+			}
+			if (at != end && *at == '.' && significant <= 15)
+				for (at++; at != end && *at >= '0' && *at <= '9'; at++) {
+					mantissa = mantissa * 10 + uint64_t(*at - '0');
+					exponent--;
+					if (mantissa) significant++;
+					if (significant > 15) break;
+				}
+			if (at != end && (*at == 'e' || *at == 'E') && significant <= 15) {
+				at++;
+				bool negativeExponent = (at != end && *at == '-');
+				if (at != end && (*at == '-' || *at == '+')) at++;
+				int written = 0;
+				for (; at != end && *at >= '0' && *at <= '9' && written < 1000; at++)
+					written = written * 10 + (*at - '0');
+				exponent += negativeExponent ? -written : written;
+			}
+			if (at == end && significant <= 15 && exponent >= -22 && exponent <= 22) {
+				double value = double(mantissa);
+				value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+				return negative ? -value : value;
+			}
+			std::istringstream parsing(std::string(begin, end));
+			parsing.imbue(std::locale::classic());
+			double number = 0;
+			parsing >> number;
+			return number;
+		}
+
+		double readNumber() {
+			const char* begin = position - 1;
+			while (position != end && (*position == '-' || *position == '+' || *position == 'E' || *position == 'e'
+					|| *position == '.' || (*position >= '0' && *position <= '9')))
+				position++;
+			return parseNumber(begin, position);
+		}
+
+		std::shared_ptr<JSON> parse() {
+			char letter = next();
+			if (letter == '"') {
+				const char* begin;
+				size_t size;
+				std::string decoded;
+				if (!readString(begin, size, decoded))
+					return std::make_shared<JSONstring>(decoded);
+				if (borrowStrings)
+					return std::make_shared<JSONstringView>(begin, size);
+				return std::make_shared<JSONstring>(std::string(begin, size));
+			}
+			else if (letter == 't') {
+				expectWord("rue", "true");
+				return std::make_shared<JSONbool>(true);
+			}
+			else if (letter == 'f') {
+				expectWord("alse", "false");
+				return std::make_shared<JSONbool>(false);
+			}
+			else if (letter == 'n') {
+				expectWord("ull", "null");
+				return std::make_shared<JSON>();
+			}
+			else if (letter == '-' || (letter >= '0' && letter <= '9')) {
+				return std::make_shared<JSONdouble>(readNumber());
+			}
+			else if (letter == '{') {
+				auto retval = std::make_shared<JSONobject>();
+				std::string decoded;
+				for (letter = next(); letter != '}'; letter = next()) {
+					if (letter != '"')
+						throw(std::runtime_error(letter ? std::string("JSON parser expected a key but found ") + letter
+								: std::string("JSON parser found an unterminated object")));
+					const char* begin;
+					size_t size;
+					bool direct = readString(begin, size, decoded);
+					JSONkey name = keys.intern(direct ? std::string(begin, size) : decoded);
+					if (next() != ':') throw(std::runtime_error("JSON parser expected an additional ':' somewhere"));
+					retval->getObject()[name] = parse();
+				}
+				return retval;
+			}
+			else if (letter == '[') {
+				auto retval = std::make_shared<JSONarray>();
+				for (letter = next(); letter != ']'; letter = next()) {
+					if (!letter)
+						throw(std::runtime_error("JSON parser found an unterminated array"));
+					// Numbers are parsed in bulk until something else appears
+					if ((letter == '-' || (letter >= '0' && letter <= '9')) && retval->contents_.empty())
+						retval->numbers_.push_back(readNumber());
+					else {
+						position--;
+						retval->getVector().push_back(parse());
+					}
 				}
-				letter = char(in.get());
+				return retval;
+			} else if (!letter) {
+				throw(std::runtime_error("JSON parser found an unexpected end"));
+			} else {
+				throw(std::runtime_error(std::string("JSON parser found unexpected character ") + letter));
 			}
-			return collected;
+		}
+	};
+
+	static bool readFile(const std::string& fileName, std::string& into) {
+		std::ifstream in(fileName, std::ios::binary);
+		if (!in.good()) return false;
+		// Compressed files are recognised by their magic numbers and decompressed as they are read
+		unsigned char magic[4] = { 0, 0, 0, 0 };
+		in.read(reinterpret_cast<char*>(magic), sizeof(magic));
+		in.clear();
+		in.seekg(0, std::ios::beg);
+#ifdef QUICK_PREFERENCES_ZLIB
+		if (magic[0] == 0x1f && magic[1] == 0x8b) {
+			readGzip(in, into);
+			return true;
+		}
+#endif
+#ifdef QUICK_PREFERENCES_ZSTD
+		if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+			readZstd(in, into);
+			return true;
+		}
+#endif
+		in.seekg(0, std::ios::end);
+		std::streamoff size = in.tellg();
+		in.seekg(0, std::ios::beg);
+		if (size > 0) {
+			into.resize(size_t(size));
+			in.read(&into[0], size);
+			into.resize(size_t(in.gcount()));
+		} else
+			into.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	// Not cryptographic, only to notice that a file was changed, reads eight bytes at a time
+	static uint64_t contentHash(const char* data, size_t size) {
+		uint64_t hash = 14695981039346656037ull ^ size;
+		size_t position = 0;
+		for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, data + position, sizeof(uint64_t));
+			hash = (hash ^ word) * 1099511628211ull;
+			hash ^= hash >> 29;
+		}
+		for (; position < size; position++)
+			hash = (hash ^ uint8_t(data[position])) * 1099511628211ull;
+		return hash;
+	}
+
+public:
+	/*!
+	* \brief Parses JSON from a buffer in memory
+	* \param Start of the buffer
+	* \param End of the buffer
+	* \param The table used to intern the keys
+	* \param If true, strings without escape sequences refer to the buffer instead of being copied, the buffer must outlive the result
+	* \return The parsed structure, the null type if the buffer is blank
+	*/
+	static std::shared_ptr<JSON> parseJSON(const char* begin, const char* end, KeyTable& keys, bool borrowStrings = false) {
+		JSONparser parser{begin, end, keys, borrowStrings};
+		if (!parser.next()) return std::make_shared<JSON>();
+		parser.position--;
+		return parser.parse();
+	}
+	static std::shared_ptr<JSON> parseJSON(std::istream& in, KeyTable& keys) {
+		std::string buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		return parseJSON(buffer.data(), buffer.data() + buffer.size(), keys);
+	}
+	static std::shared_ptr<JSON> parseJSON(std::istream& in) {
+		KeyTable keys;
+		return parseJSON(in, keys);
+	}
+	static std::shared_ptr<JSON> parseJSON(const std::string& fileName) {
+		std::string buffer;
+		if (!readFile(fileName, buffer)) return std::make_shared<JSON>();
+		KeyTable keys;
+		return parseJSON(buffer.data(), buffer.data() + buffer.size(), keys);
+	}
+
+	/*!
+	* \brief Parses JSON that arrives in chunks, keeping its state between them
+	*
+	* \note Feed it chunks as they arrive, the structure is available when feed() returns true
+	* \note Data after the end of the document are ignored, a document that is a single number must be followed by whitespace
+	*/
+	class JSONpushParser {
+		enum class State : uint8_t {
+			VALUE,
+			KEY,
+			COLON,
+			STRING,
+			NUMBER,
+			WORD,
+			DONE
 		};
-		auto readWhitespace = [&in] () -> char {
-			char letter;
-			do {
-				letter = char(in.get());
-			} while (letter == ' ' || letter == '\t' || letter == '\n' || letter == ',');
-			return letter;
+		struct Frame {
+			std::shared_ptr<JSON> container;
+			JSONarray* array;
+			JSONobject* object;
+			JSONkey key;
 		};
+		State state_ = State::VALUE;
+		bool stringIsKey_ = false;
+		bool escaped_ = false;
+		std::string token_;
+		const char* word_ = nullptr;
+		unsigned int wordPosition_ = 0;
+		std::vector<Frame> stack_;
+		std::shared_ptr<JSON> result_;
+		KeyTable keys_;
+		size_t used_ = 0;
 
-		char letter = readWhitespace();
-		if (letter == 0 || letter == EOF) return std::make_shared<JSON>();
-		else if (letter == '"') {
-			return std::make_shared<JSONstring>(readString());
+		void emitValue(std::shared_ptr<JSON> value) {
+			if (stack_.empty()) {
+				result_ = value;
+				state_ = State::DONE;
+			} else if (stack_.back().array) {
+				stack_.back().array->getVector().push_back(value);
+				state_ = State::VALUE;
+			} else {
+				stack_.back().object->contents_[stack_.back().key] = value;
+				state_ = State::KEY;
+			}
 		}
-		else if (letter == 't') {
-			if (in.get() == 'r' && in.get() == 'u' && in.get() == 'e')
-				return std::make_shared<JSONbool>(true);
-			else
-				throw(std::runtime_error("JSON parser found misspelled bool 'true'"));
+		void emitNumber(double value) {
+			if (!stack_.empty() && stack_.back().array && stack_.back().array->contents_.empty()) {
+				stack_.back().array->numbers_.push_back(value);
+				state_ = State::VALUE;
+			} else
+				emitValue(std::make_shared<JSONdouble>(value));
 		}
-		else if (letter == 'f') {
-			if (in.get() == 'a' && in.get() == 'l' && in.get() == 's' && in.get() == 'e')
-				return std::make_shared<JSONbool>(false);
-			else
-				throw(std::runtime_error("JSON parser found misspelled bool 'false'"));
+		void finishString() {
+			token_.push_back('"');
+			JSONparser parser{token_.data(), token_.data() + token_.size(), keys_, false};
+			const char* begin;
+			size_t size;
+			std::string decoded;
+			if (parser.readString(begin, size, decoded))
+				decoded.assign(begin, size);
+			if (stringIsKey_) {
+				stack_.back().key = keys_.intern(decoded);
+				state_ = State::COLON;
+			} else
+				emitValue(std::make_shared<JSONstring>(decoded));
 		}
-		else if (letter == 'n') {
-			if (in.get() == 'u' && in.get() == 'l' && in.get() == 'l')
-				return std::make_shared<JSON>();
+		void finishWord() {
+			if (word_[0] == 'n')
+				emitValue(std::make_shared<JSON>());
 			else
-				throw(std::runtime_error("JSON parser found misspelled bool 'null'"));
+				emitValue(std::make_shared<JSONbool>(word_[0] == 't'));
 		}
-		else if (letter == '-' || (letter >= '0' && letter <= '9')) {
-			std::string asString;
-			asString.push_back(letter);
-			do {
-				letter = char(in.get());
-				asString.push_back(letter);
-			} while (letter == '-' || letter == 'E' || letter == 'e' || letter == ',' || letter == '.' || (letter >= '0' && letter <= '9'));
-			in.unget();
-			std::stringstream parsing(asString);
-			double number;
-			parsing >> number;
-			return std::make_shared<JSONdouble>(number);
+		void openContainer(bool isObject) {
+			Frame frame = { nullptr, nullptr, nullptr, JSONkey("") };
+			if (isObject) {
+				auto made = std::make_shared<JSONobject>();
+				frame.object = made.get();
+				frame.container = made;
+			} else {
+				auto made = std::make_shared<JSONarray>();
+				frame.array = made.get();
+				frame.container = made;
+			}
+			stack_.push_back(frame);
+			state_ = isObject ? State::KEY : State::VALUE;
 		}
-		else if (letter == '{') {
-			auto retval = std::make_shared<JSONobject>();
-			do {
-				letter = readWhitespace();
+		void closeContainer() {
+			std::shared_ptr<JSON> closed = stack_.back().container;
+			stack_.pop_back();
+			emitValue(closed);
+		}
+		void structural(char letter) {
+			if (state_ == State::COLON) {
+				if (letter != ':') throw(std::runtime_error("JSON parser expected an additional ':' somewhere"));
+				state_ = State::VALUE;
+			} else if (state_ == State::KEY) {
 				if (letter == '"') {
-					const std::string& name = readString();
-					letter = readWhitespace();
-					if (letter != ':') throw(std::runtime_error("JSON parser expected an additional ':' somewhere"));
-					retval->getObject()[name] = parseJSON(in);
-				} else break;
-			} while (letter != '}');
-			return std::move(retval);
-		}
-		else if (letter == '[') {
-			auto retval = std::make_shared<JSONarray>();
-			do {
-				letter = readWhitespace();
-				if (letter == '{') {
-					in.unget();
-					retval->getVector().push_back(parseJSON(in));
-				} else break;
-			} while (letter != ']');
-			return std::move(retval);
-		} else {
-			throw(std::runtime_error(std::string("JSON parser found unexpected character ") + letter));
-		}
-		return std::make_shared<JSON>();
-	}
-	static std::shared_ptr<JSON> parseJSON(const std::string& fileName) {
-		std::ifstream in(fileName);
-		if (!in.good()) return std::make_shared<JSON>();
-		return parseJSON(in);
+					state_ = State::STRING;
+					stringIsKey_ = true;
+					token_.clear();
+				} else if (letter == '}')
+					closeContainer();
+				else
+					throw(std::runtime_error(std::string("JSON parser expected a key but found ") + letter));
+			} else if (letter == '"') {
+				state_ = State::STRING;
+				stringIsKey_ = false;
+				token_.clear();
+			} else if (letter == '{' || letter == '[')
+				openContainer(letter == '{');
+			else if (letter == ']' && !stack_.empty() && stack_.back().array)
+				closeContainer();
+			else if (letter == '-' || (letter >= '0' && letter <= '9')) {
+				state_ = State::NUMBER;
+				token_.assign(1, letter);
+			} else if (letter == 't' || letter == 'f' || letter == 'n') {
+				state_ = State::WORD;
+				word_ = (letter == 't') ? "true" : (letter == 'f') ? "false" : "null";
+				wordPosition_ = 1;
+			} else
+				throw(std::runtime_error(std::string("JSON parser found unexpected character ") + letter));
+		}
+
+	public:
+		/*!
+		* \brief Parses another chunk of the document
+		* \param The chunk
+		* \param Size of the chunk
+		* \return true if the document is complete
+		*
+		* \note Parsing stops at the end of the document, used() tells where the rest of the chunk starts
+		* \note A number at the end of the input is complete only after finish() is called
+		*/
+		bool feed(const char* data, size_t size) {
+			const char* at = data;
+			const char* end = data + size;
+			while (at != end && state_ != State::DONE) {
+				char letter = *at;
+				if (state_ == State::STRING) {
+					const char* start = at;
+					for (; at != end; at++) {
+						if (escaped_) escaped_ = false;
+						else if (*at == '\\') escaped_ = true;
+						else if (*at == '"') break;
+					}
+					token_.append(start, at);
+					if (at != end) {
+						at++;
+						finishString();
+					}
+				} else if (state_ == State::NUMBER) {
+					if (letter == '-' || letter == '+' || letter == 'E' || letter == 'e' || letter == '.' || (letter >= '0' && letter <= '9')) {
+						token_.push_back(letter);
+						at++;
+					} else
+						emitNumber(JSONparser::parseNumber(token_.data(), token_.data() + token_.size()));
+				} else if (state_ == State::WORD) {
+					if (letter != word_[wordPosition_])
+						throw(std::runtime_error(std::string("JSON parser found misspelled '") + word_ + "'"));
+					at++;
+					if (!word_[++wordPosition_])
+						finishWord();
+				} else {
+					at++;
+					if (letter != ' ' && letter != '\t' && letter != '\n' && letter != '\r' && letter != ',')
+						structural(letter);
+				}
+			}
+			used_ = size_t(at - data);
+			return state_ == State::DONE;
+		}
+
+		/*!
+		* \brief Returns how many bytes of the last chunk belonged to the document
+		*
+		* \note If the document is complete, the remaining bytes can be fed after reset() as the next document
+		*/
+		size_t used() const {
+			return used_;
+		}
+
+		/*!
+		* \brief Marks the end of the input, completing a number that may continue in the next chunk otherwise
+		* \return true if the document is complete
+		*/
+		bool finish() {
+			if (state_ == State::NUMBER && stack_.empty())
+				emitNumber(JSONparser::parseNumber(token_.data(), token_.data() + token_.size()));
+			return state_ == State::DONE;
+		}
+
+		/*!
+		* \brief Returns if the whole document was parsed
+		*/
+		bool done() const {
+			return state_ == State::DONE;
+		}
+
+		/*!
+		* \brief Returns the parsed document
+		* \return The structure
+		*
+		* \note Throws if the document isn't complete yet
+		*/
+		std::shared_ptr<JSON> result() const {
+			if (state_ != State::DONE) throw(std::logic_error("The JSON document is not complete yet"));
+			return result_;
+		}
+
+		/*!
+		* \brief Prepares the parser for another document
+		*/
+		void reset() {
+			state_ = State::VALUE;
+			escaped_ = false;
+			token_.clear();
+			stack_.clear();
+			result_ = nullptr;
+			keys_ = KeyTable();
+			used_ = 0;
+		}
+	};
+
+#ifndef QUICK_PREFERENCES_NO_GUI
+	/*!
+	* \brief Collects the changes made through a generated GUI and reports them in a single call
+	*
+	* \note The callback is called once per event loop turn or once per time window, with the paths of all values changed since
+	* \note Paths are keys separated by slashes, elements of vectors are identified by their index, like chapters/2/author
+	*/
+	class ChangeBatch {
+		std::function<void(const std::set<std::string>&)> callback_;
+		std::set<std::string> changed_;
+		QTimer timer_;
+	public:
+		/*!
+		* \brief Constructs the batch
+		* \param The function called with the set of changed paths
+		* \param How long to collect changes before calling it, 0 means until the event loop is reached
+		*/
+		ChangeBatch(std::function<void(const std::set<std::string>&)> callback, int windowMilliseconds = 0) :
+				callback_(callback) {
+			timer_.setSingleShot(true);
+			timer_.setInterval(windowMilliseconds);
+			QObject::connect(&timer_, &QTimer::timeout, &timer_, [this] () {
+				flush();
+			});
+		}
+
+		/*!
+		* \brief Marks a value as changed, it will be reported when the batch is flushed
+		* \param Path to the value
+		*/
+		void changed(const std::string& path) {
+			changed_.insert(path);
+			if (!timer_.isActive())
+				timer_.start();
+		}
+
+		/*!
+		* \brief Reports all pending changes immediately
+		*/
+		void flush() {
+			timer_.stop();
+			if (changed_.empty()) return;
+			std::set<std::string> reported;
+			reported.swap(changed_);
+			callback_(reported);
+		}
+	};
+#endif
+
+	/*!
+	* \brief Describes a member to be synchronised by a QuickPreferencesFields descendant
+	*/
+	template <typename Owner, typename Member>
+	struct Field {
+		const char* name;
+		Member Owner::* member;
+		uint64_t hash;
+	};
+
+	/*!
+	* \brief Creates a description of a member to be synchronised
+	* \param The name of the value in the output/input file
+	* \param Pointer to the member
+	* \return The description, with the hash of the name computed at compile time
+	*/
+	template <typename Owner, typename Member>
+	static constexpr Field<Owner, Member> field(const char* name, Member Owner::* member) {
+		return Field<Owner, Member>{name, member, keyHash(name)};
 	}
+
+	/*!
+	* \brief Holds a value that is shared by copies of the object holding it, until one of them changes it
+	*
+	* \note Loading makes a private copy only if the loaded file contains the value, so copies of an object with defaults
+	* that load only a few overrides keep sharing the rest
+	* \note It can hold any type supported by synch()
+	* \note If it holds an object derived from QuickPreferences, saving or measuring uses the shared object's state, so objects
+	* sharing it must not be saved or measured from different threads at the same time
+	*/
+	template <typename T>
+	class CopyOnWrite {
+		std::shared_ptr<T> shared_;
+	public:
+		CopyOnWrite() : shared_(std::make_shared<T>()) {}
+		CopyOnWrite(const T& value) : shared_(std::make_shared<T>(value)) {}
+
+		inline const T& operator*() const {
+			return *shared_;
+		}
+		inline const T* operator->() const {
+			return shared_.get();
+		}
+		/*!
+		* \brief Allows changing the value, copying it first if it's shared
+		* \return Reference to the value, valid until the holder is copied
+		*/
+		T& edit() {
+			if (shared_.use_count() > 1)
+				shared_ = std::make_shared<T>(*shared_);
+			return *shared_;
+		}
+		/*!
+		* \brief Returns if the value is shared with another copy
+		*/
+		inline bool shared() const {
+			return shared_.use_count() > 1;
+		}
+	};
 protected:
 
 	enum class ActionType : uint8_t {
 		LOADING,
 		SAVING,
+#ifndef QUICK_PREFERENCES_NO_GUI
 		GUI,
-		GUItable
+		GUItable,
+#endif
+		MEASURING
 	};
 
+	// Key of the member being synchronised by a QuickPreferencesFields descendant, with its hash computed at compile time
+	static const JSONkey*& fieldKey() {
+		static thread_local const JSONkey* key = nullptr;
+		return key;
+	}
+
 private:
 
+#ifndef QUICK_PREFERENCES_NO_GUI
 	struct GUImakingInfo {
 		QGridLayout* layout = nullptr;
 		int gridDown = 0;
 		int gridRight = 0;
 		std::shared_ptr<std::function<void()>> callback;
+		bool lazy = false;
+		std::shared_ptr<ChangeBatch> batch;
+		std::string path;
 	};
+#endif
 	mutable union {
 		JSON* preferencesJson;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		GUImakingInfo* guiInfo;
+#endif
+		MemoryCounter* memory;
 	} actionData_;
 	mutable ActionType action_;
 
+	// Keys of the document being saved on this thread, so that all objects in it share them
+	static KeyTable*& savingKeys() {
+		static thread_local KeyTable* keys = nullptr;
+		return keys;
+	}
+	struct SavingKeysScope {
+		KeyTable keys;
+		KeyTable* previous;
+		SavingKeysScope() : previous(savingKeys()) {
+			savingKeys() = &keys;
+		}
+		SavingKeysScope(KeyTable& shared) : previous(savingKeys()) {
+			savingKeys() = &shared;
+		}
+		~SavingKeysScope() {
+			savingKeys() = previous;
+		}
+	};
+
+	// Keys looked up by the elements of a vector being loaded on this thread, by the position of the synch() call,
+	// after the first element they are only compared with the key given to synch() and found by identity without hashing
+	struct LoadingKeys {
+		std::vector<JSONkey> order;
+		size_t call = 0;
+	};
+	static LoadingKeys*& loadingKeys() {
+		static thread_local LoadingKeys* keys = nullptr;
+		return keys;
+	}
+	struct LoadingKeysScope {
+		LoadingKeys keys;
+		LoadingKeys* previous;
+		LoadingKeysScope() : previous(loadingKeys()) {
+			loadingKeys() = &keys;
+		}
+		~LoadingKeysScope() {
+			loadingKeys() = previous;
+		}
+		inline void nextElement() {
+			keys.call = 0;
+		}
+	};
+
+	// Transient memory of the last load or save on this thread
+	struct PeakMemory {
+		bool tracking = false;
+		MemoryUsage last;
+	};
+	static PeakMemory& peakMemory() {
+		static thread_local PeakMemory peak;
+		return peak;
+	}
+	// Nodes shared by the structures are counted once, keepLarger is for multiple documents processed in one call
+	static void recordPeakMemory(std::initializer_list<JSON*> structures, size_t buffers, bool keepLarger = false) {
+		PeakMemory& peak = peakMemory();
+		if (!peak.tracking)
+			return;
+		MemoryCounter counter;
+		for (JSON* structure : structures)
+			structure->measure(counter);
+		counter.usage.buffers = buffers;
+		if (!keepLarger || counter.usage.total() > peak.last.total())
+			peak.last = counter.usage;
+	}
+	static void recordPeakMemory(JSON& structure, size_t buffers) {
+		recordPeakMemory({ &structure }, buffers);
+	}
+
+	std::shared_ptr<JSON> savedJSON() const {
+		std::shared_ptr<JSON> target = std::make_shared<JSONobject>();
+		actionData_.preferencesJson = target.get();
+		action_ = ActionType::SAVING;
+		const_cast<QuickPreferences*>(this)->process();
+		actionData_.preferencesJson = nullptr;
+		return target;
+	}
+	// Both complete structures are returned too, so that the memory used can be measured
+	std::shared_ptr<JSON> differenceFrom(const QuickPreferences& base, std::shared_ptr<JSON>& original, std::shared_ptr<JSON>& modified) const {
+		SavingKeysScope keys;
+		original = base.savedJSON();
+		modified = savedJSON();
+		std::shared_ptr<JSON> difference = differenceJSON(modified, *original);
+		return difference ? difference : std::make_shared<JSONobject>();
+	}
+
+	// Keys of described fields are recognised by address, so that their hash is not computed again
+	std::shared_ptr<JSON>& savedValue(const std::string& key) {
+		const JSONkey* described = fieldKey();
+		if (described && &described->str() == &key)
+			return actionData_.preferencesJson->keySlot(*described, savingKeys());
+		return actionData_.preferencesJson->memberSlot(key, savingKeys());
+	}
+
+	void loadFromJSON(JSON& source) {
+		if (source.type() == JSONtype::NIL)
+			return;
+		actionData_.preferencesJson = &source;
+		action_ = ActionType::LOADING;
+		process();
+		actionData_.preferencesJson = nullptr;
+	}
+
+	JSON* loadedValue(const std::string& key) {
+		const JSONkey* described = fieldKey();
+		if (described && &described->str() != &key)
+			described = nullptr;
+		LoadingKeys* cached = loadingKeys();
+		if (!cached) {
+			if (described)
+				return actionData_.preferencesJson->findKey(*described);
+			return actionData_.preferencesJson->findMember(key);
+		}
+		if (cached->call == cached->order.size())
+			cached->order.push_back(described ? *described : JSONkey(key));
+		else if (cached->order[cached->call].str() != key)
+			cached->order[cached->call] = described ? *described : JSONkey(key);
+		JSONkey& lookup = cached->order[cached->call++];
+		return actionData_.preferencesJson->findKey(lookup, &lookup);
+	}
+
+#ifndef QUICK_PREFERENCES_NO_GUI
 	void placeTableWidget(QWidget* placed, const std::string& title) {
 		if (actionData_.guiInfo->gridDown == 1)
 			actionData_.guiInfo->layout->addWidget(new QLabel(QString::fromStdString(title)), 0, actionData_.guiInfo->gridRight);
@@ -321,6 +1823,236 @@ private:
 		actionData_.guiInfo->gridRight++;
 	}
 
+	std::function<void()> changeNotifier(const std::string& key) {
+		std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
+		std::shared_ptr<ChangeBatch> batch = actionData_.guiInfo->batch;
+		std::string path = actionData_.guiInfo->path + key;
+		return [callback, batch, path] () {
+			if (callback) (*callback)();
+			if (batch) batch->changed(path);
+		};
+	}
+
+	void makeInheritedGUI(ActionType type, QGridLayout* layout, int gridDown, int gridRight, const GUImakingInfo& inherited, const std::string& path) {
+		action_ = type;
+		std::unique_ptr<GUImakingInfo> info(new GUImakingInfo());
+		info->lazy = inherited.lazy;
+		info->batch = inherited.batch;
+		info->path = path;
+		actionData_.guiInfo = info.get();
+		constructGUI(layout, gridDown, gridRight, inherited.callback);
+		actionData_.guiInfo = nullptr;
+	}
+
+	static QWidget* makeCollapsible(const std::string& title, std::function<void(QGridLayout*)> fill) {
+		QWidget* section = new QWidget;
+		QVBoxLayout* sectionLayout = new QVBoxLayout;
+		sectionLayout->setContentsMargins(0, 0, 0, 0);
+		section->setLayout(sectionLayout);
+		QToolButton* expander = new QToolButton;
+		expander->setText(QString::fromStdString(title));
+		expander->setCheckable(true);
+		expander->setArrowType(Qt::RightArrow);
+		expander->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
+		expander->setAutoRaise(true);
+		sectionLayout->addWidget(expander);
+		QFrame* body = new QFrame;
+		body->setVisible(false);
+		sectionLayout->addWidget(body);
+		// The contents are constructed only when the section is first expanded
+		QObject::connect(expander, &QToolButton::toggled, body, [expander, body, fill] (bool expanded) {
+			if (expanded && !body->layout()) {
+				QGridLayout* bodyLayout = new QGridLayout;
+				body->setLayout(bodyLayout);
+				fill(bodyLayout);
+			}
+			expander->setArrowType(expanded ? Qt::DownArrow : Qt::RightArrow);
+			body->setVisible(expanded);
+		});
+		return section;
+	}
+
+	void fillGUI(QGridLayout* layout, const GUImakingInfo& inherited, const std::string& path, const std::function<void()>& synchronise) {
+		ActionType previousAction = action_;
+		auto previousData = actionData_;
+		GUImakingInfo info;
+		info.layout = layout;
+		info.callback = inherited.callback;
+		info.lazy = inherited.lazy;
+		info.batch = inherited.batch;
+		info.path = path;
+		action_ = ActionType::GUI;
+		actionData_.guiInfo = &info;
+		synchronise();
+		action_ = previousAction;
+		actionData_ = previousData;
+	}
+#endif
+
+	template <typename T>
+	struct isScalar : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_same<T, std::string>::value> {};
+	template <typename T>
+	struct isScalarSequence : std::false_type {};
+	template <typename T, typename Allocator>
+	struct isScalarSequence<std::vector<T, Allocator>> : isScalar<T> {};
+	template <typename T, size_t size>
+	struct isScalarSequence<std::array<T, size>> : isScalar<T> {};
+	template <typename T>
+	struct isStringMap : std::false_type {};
+	template <typename T, typename Compare, typename Allocator>
+	struct isStringMap<std::map<std::string, T, Compare, Allocator>> : std::true_type {};
+	template <typename T, typename Hash, typename Equal, typename Allocator>
+	struct isStringMap<std::unordered_map<std::string, T, Hash, Equal, Allocator>> : std::true_type {};
+
+	template <typename T, typename Allocator>
+	static size_t resizeSequence(std::vector<T, Allocator>& sequence, size_t size) {
+		sequence.resize(size);
+		return size;
+	}
+	template <typename T, size_t maximum>
+	static size_t resizeSequence(std::array<T, maximum>&, size_t size) {
+		return std::min(maximum, size);
+	}
+
+	// A std::shared_ptr may hold a value shared with copies of the owner, it's copied before loading into it
+	template <typename T>
+	static void unsharePointee(std::shared_ptr<T>& pointer) {
+		if (pointer.use_count() > 1)
+			pointer = std::make_shared<T>(*pointer);
+	}
+	template <typename T>
+	static void unsharePointee(T&) {}
+
+	// Non-finite numbers are written as null, floating point values read them back as NaN
+	template <typename T>
+	static T numberFromJSON(JSON& from) {
+		if (std::is_floating_point<T>::value && from.type() == JSONtype::NIL)
+			return std::numeric_limits<T>::quiet_NaN();
+		return T(from.getDouble());
+	}
+	template <typename T>
+	static T numberFromJSON(double from) {
+		if (!std::is_floating_point<T>::value && std::isnan(from))
+			throw(std::runtime_error("Integer value is not really a number"));
+		return T(from);
+	}
+
+	template <typename T>
+	static typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, std::shared_ptr<JSON>>::type
+	scalarToJSON(const T& value) {
+		return std::make_shared<JSONdouble>(double(value));
+	}
+	static std::shared_ptr<JSON> scalarToJSON(bool value) {
+		return std::make_shared<JSONbool>(value);
+	}
+	static std::shared_ptr<JSON> scalarToJSON(const std::string& value) {
+		return std::make_shared<JSONstring>(value);
+	}
+	template <typename T>
+	static typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type
+	scalarFromJSON(JSON& from, T& value) {
+		value = numberFromJSON<T>(from);
+	}
+	static void scalarFromJSON(JSON& from, bool& value) {
+		value = from.getBool();
+	}
+	static void scalarFromJSON(JSON& from, std::string& value) {
+		from.copyString(value);
+	}
+
+	template <typename T>
+	static typename std::enable_if<std::is_arithmetic<typename T::value_type>::value && !std::is_same<typename T::value_type, bool>::value>::type
+	sequenceToJSON(const T& value, JSONarray& making) {
+		making.numbers_.assign(value.begin(), value.end());
+	}
+	template <typename T>
+	static typename std::enable_if<!std::is_arithmetic<typename T::value_type>::value || std::is_same<typename T::value_type, bool>::value>::type
+	sequenceToJSON(const T& value, JSONarray& making) {
+		making.contents_.reserve(value.size());
+		for (auto it = value.begin(); it != value.end(); ++it)
+			making.contents_.push_back(scalarToJSON(typename T::value_type(*it)));
+	}
+	template <typename T>
+	static typename std::enable_if<std::is_arithmetic<typename T::value_type>::value && !std::is_same<typename T::value_type, bool>::value>::type
+	sequenceFromJSON(JSON& from, T& value) {
+		const std::vector<double>& numbers = from.getNumbers();
+		size_t size = resizeSequence(value, numbers.size());
+		for (size_t i = 0; i < size; i++)
+			value[i] = numberFromJSON<typename T::value_type>(numbers[i]);
+	}
+	template <typename T>
+	static typename std::enable_if<!std::is_arithmetic<typename T::value_type>::value || std::is_same<typename T::value_type, bool>::value>::type
+	sequenceFromJSON(JSON& from, T& value) {
+		const std::vector<std::shared_ptr<JSON>>& elements = from.getVector();
+		size_t size = resizeSequence(value, elements.size());
+		for (size_t i = 0; i < size; i++) {
+			typename T::value_type element;
+			scalarFromJSON(*elements[i], element);
+			value[i] = std::move(element);
+		}
+	}
+
+#ifndef QUICK_PREFERENCES_NO_GUI
+	template <typename T>
+	static typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, std::string>::type
+	scalarToText(const T& value) {
+		std::stringstream out;
+		out << +value;
+		return out.str();
+	}
+	static std::string scalarToText(bool value) {
+		return value ? "true" : "false";
+	}
+	static std::string scalarToText(const std::string& value) {
+		return value;
+	}
+	template <typename T>
+	static typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type
+	scalarFromText(const std::string& text, T& value) {
+		std::stringstream in(text);
+		double number = 0;
+		in >> number;
+		value = T(number);
+	}
+	static void scalarFromText(const std::string& text, bool& value) {
+		value = (text == "true" || text == "1");
+	}
+	static void scalarFromText(const std::string& text, std::string& value) {
+		value = text;
+	}
+#endif
+
+	static size_t stringHeap(const std::string& text) {
+		static const size_t local = std::string().capacity();
+		return (text.capacity() > local) ? text.capacity() + 1 : 0;
+	}
+	template <typename T>
+	static size_t scalarHeap(const T&) {
+		return 0;
+	}
+	static size_t scalarHeap(const std::string& value) {
+		return stringHeap(value);
+	}
+	template <typename T, typename Allocator>
+	static size_t containerHeap(const std::vector<T, Allocator>& container) {
+		return container.capacity() * sizeof(T);
+	}
+	template <typename T, size_t size>
+	static size_t containerHeap(const std::array<T, size>&) {
+		return 0;
+	}
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	static size_t containerHeap(const std::map<Key, T, Compare, Allocator>& container) {
+		// Tree nodes have a colour and three pointers
+		return container.size() * (sizeof(typename std::map<Key, T, Compare, Allocator>::value_type) + 4 * sizeof(void*));
+	}
+	template <typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+	static size_t containerHeap(const std::unordered_map<Key, T, Hash, Equal, Allocator>& container) {
+		// Entries have a pointer to the next one and a cached hash
+		return container.bucket_count() * sizeof(void*)
+				+ container.size() * (sizeof(typename std::unordered_map<Key, T, Hash, Equal, Allocator>::value_type) + sizeof(void*) + sizeof(size_t));
+	}
+
 protected:
 	/*!
 	* \brief Should all the synch() method on all members that are to be saved
@@ -342,6 +2074,7 @@ protected:
 		return action_;
 	}
 
+#ifndef QUICK_PREFERENCES_NO_GUI
 	/*!
 	* \brief Prepares internal parameters for the synch() calls made by process()
 	* \param The layout it should fill
@@ -357,6 +2090,7 @@ protected:
 		actionData_.guiInfo->layout = layout;
 		actionData_.guiInfo->callback = callback;
 	}
+#endif
 
 	/*!
 	* \brief Saves or loads a string value
@@ -367,24 +2101,28 @@ protected:
 	inline bool synch(const std::string& key, std::string& value) {
 		switch (action_) {
 		case ActionType::SAVING:
-			actionData_.preferencesJson->getObject()[key] = std::make_shared<JSONstring>(value);
+			savedValue(key) = std::make_shared<JSONstring>(value);
 			return true;
 		case ActionType::LOADING:
 		{
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				value = found->second->getString();
+			JSON* found = loadedValue(key);
+			if (found) {
+				found->copyString(value);
 				return true;
 			} else return false;
 		}
+		case ActionType::MEASURING:
+			actionData_.memory->usage.strings += stringHeap(value);
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
 			actionData_.guiInfo->layout->addWidget(new QLabel(QString::fromStdString(key + ":")), actionData_.guiInfo->gridDown, 0);
 		case ActionType::GUItable:
 			QLineEdit* editor = new QLineEdit(QString::fromStdString(value));
-			std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
-			QObject::connect(editor, &QLineEdit::editingFinished, actionData_.guiInfo->layout, [&value, editor, callback]() {
+			std::function<void()> notify = changeNotifier(key);
+			QObject::connect(editor, &QLineEdit::editingFinished, actionData_.guiInfo->layout, [&value, editor, notify]() {
 				value = editor->text().toStdString();
-				if (callback) (*callback)();
+				notify();
 			});
 			if (action_ == ActionType::GUI) {
 				actionData_.guiInfo->layout->addWidget(editor, actionData_.guiInfo->gridDown, 1);
@@ -392,7 +2130,9 @@ protected:
 			}
 			else placeTableWidget(editor, key);
 			return true;
+#endif
 		}
+		return false;
 	}
 	
 	/*!
@@ -402,33 +2142,37 @@ protected:
 	* \return false if the value was absent while reading, true otherwise
 	*
 	* \note The value is converted from and to a double for JSON conformity
+	* \note Infinities and NaN are saved as null, floating point values load null as NaN
 	*/
 	template<typename T>
 	typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, bool>::type
 	synch(const std::string& key, T& value) {
 		switch (action_) {
 		case ActionType::SAVING:
-			actionData_.preferencesJson->getObject()[key] = std::make_shared<JSONdouble>(double(value));
+			savedValue(key) = std::make_shared<JSONdouble>(double(value));
 			return true;
 		case ActionType::LOADING:
 		{
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				value = T(found->second->getDouble());
+			JSON* found = loadedValue(key);
+			if (found) {
+				value = numberFromJSON<T>(*found);
 				return true;
 			} return false;
 		}
+		case ActionType::MEASURING:
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
 			actionData_.guiInfo->layout->addWidget(new QLabel(QString::fromStdString(key + ":")), actionData_.guiInfo->gridDown, 0);
 		case ActionType::GUItable:
 			QLineEdit* editor = new QLineEdit(QString::fromStdString(std::to_string(value)));
-			std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
-			QObject::connect(editor, &QLineEdit::editingFinished, actionData_.guiInfo->layout, [&value, editor, callback]() {
+			std::function<void()> notify = changeNotifier(key);
+			QObject::connect(editor, &QLineEdit::editingFinished, actionData_.guiInfo->layout, [&value, editor, notify]() {
 				if (std::is_integral<T>::value)
 					value = editor->text().toLong();
 				else
 					value = editor->text().toDouble();
-				if (callback) (*callback)();
+				notify();
 			});
 			if (action_ == ActionType::GUI) {
 				actionData_.guiInfo->layout->addWidget(editor, actionData_.guiInfo->gridDown, 1);
@@ -436,7 +2180,9 @@ protected:
 			}
 			else placeTableWidget(editor, key);
 			return true;
+#endif
 		}
+		return false;
 	}
 
 	/*!
@@ -448,24 +2194,27 @@ protected:
 	inline bool synch(const std::string& key, bool& value) {
 		switch (action_) {
 		case ActionType::SAVING:
-			actionData_.preferencesJson->getObject()[key] = std::make_shared<JSONbool>(value);
+			savedValue(key) = std::make_shared<JSONbool>(value);
 			return true;
 		case ActionType::LOADING:
 		{
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				value = found->second->getBool();
+			JSON* found = loadedValue(key);
+			if (found) {
+				value = found->getBool();
 				return true;
 			} else return false;
 		}
+		case ActionType::MEASURING:
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
 		case ActionType::GUItable:
 			QCheckBox* check = new QCheckBox(QString::fromStdString((action_ == ActionType::GUI) ? key : ""));
 			check->setChecked(value);
-			std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
-			QObject::connect(check, &QCheckBox::clicked, actionData_.guiInfo->layout, [&value, check, callback]() {
+			std::function<void()> notify = changeNotifier(key);
+			QObject::connect(check, &QCheckBox::clicked, actionData_.guiInfo->layout, [&value, check, notify]() {
 				value = check->isChecked();
-				if (callback) (*callback)();
+				notify();
 			});
 			if (action_ == ActionType::GUI) {
 				actionData_.guiInfo->layout->addWidget(check, actionData_.guiInfo->gridDown, 0, 1, 2);
@@ -473,7 +2222,9 @@ protected:
 			}
 			else placeTableWidget(check, key);
 			return true;
+#endif
 		}
+		return false;
 	}
 	
 	/*!
@@ -483,7 +2234,9 @@ protected:
 	* \return false if the value was absent while reading, true otherwise
 	*
 	\ \note The smart pointer class must be dereferencable through operator*(), constructible from raw pointer to the class and the ! operation must result in a number
-	* \note If not null, the contents will be overwritten, so raw pointers must be initalised before calling it, but no memory leak will occur
+	* \note If not null, the object is loaded in place and keeps the values absent from the file, so raw pointers must be initalised before calling it
+	* \note If a std::shared_ptr shares its object with another pointer, the object is copied first and the copy is loaded
+	* \note If the value is absent, the pointer is not changed
 	*/
 	template<typename T>
 	typename std::enable_if<!std::is_base_of<QuickPreferences, T>::value
@@ -494,26 +2247,33 @@ protected:
 		switch (action_) {
 		case ActionType::SAVING:
 			if (!value)
-				actionData_.preferencesJson->getObject()[key] = std::make_shared<JSON>();
+				savedValue(key) = std::make_shared<JSON>();
 			else {
 				synch(key, *value);
 			}
 			return true;
 		case ActionType::LOADING:
 		{
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				if (found->second->type() != JSONtype::NIL) {
+			JSON* found = loadedValue(key);
+			if (!found)
+				return false;
+			if (found->type() != JSONtype::NIL) {
+				if (!value)
 					value = T(new typename std::remove_reference<decltype(*std::declval<T>())>::type());
-					synch(key, *value);
-				} else
-					value = nullptr;
-				return true;
-			} else {
+				else
+					unsharePointee(value);
+				synch(key, *value);
+			} else
 				value = nullptr;
-				return false;
-			}
+			return true;
 		}
+		case ActionType::MEASURING:
+			if (value) {
+				actionData_.memory->usage.objects += sizeof(typename std::remove_reference<decltype(*std::declval<T>())>::type);
+				synch(key, *value);
+			}
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
 		case ActionType::GUItable:
 			QGroupBox* group = new QGroupBox(QString::fromStdString((action_ == ActionType::GUI) ? key : ""));
@@ -523,14 +2283,21 @@ protected:
 			group->setLayout(new QGridLayout);
 			int regularMargin = group->layout()->margin();
 			group->layout()->setMargin(0);
-			std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
-			auto fill = [&value, regularMargin, group, callback] () {
+			GUImakingInfo inherited = *actionData_.guiInfo;
+			std::string path = inherited.path + key + "/";
+			std::function<void()> notify = changeNotifier(key);
+			auto fill = [&value, regularMargin, group, inherited, path, key] () {
 				group->layout()->setMargin(regularMargin);
-				value->makeGUI(static_cast<QGridLayout*>(group->layout()), 0, 0, callback);
+				if (inherited.lazy)
+					static_cast<QGridLayout*>(group->layout())->addWidget(makeCollapsible(key, [&value, inherited, path] (QGridLayout* contents) {
+						value->makeInheritedGUI(ActionType::GUI, contents, 0, 0, inherited, path);
+					}), 0, 0);
+				else
+					value->makeInheritedGUI(ActionType::GUI, static_cast<QGridLayout*>(group->layout()), 0, 0, inherited, path);
 			};
 			if (value)
 				fill();
-			QObject::connect(group, &QGroupBox::clicked, group, [&value, group, fill, callback]() {
+			QObject::connect(group, &QGroupBox::clicked, group, [&value, group, fill, notify]() {
 				if (group->isChecked()) {
 					value = T(new typename std::remove_reference<decltype(*std::declval<T>())>::type());
 					fill();
@@ -541,7 +2308,7 @@ protected:
 					group->layout()->setMargin(0);
 					value = nullptr;
 				}
-				if (callback) (*callback)();
+				notify();
 			});
 			if (action_ == ActionType::GUI) {
 				actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
@@ -549,7 +2316,9 @@ protected:
 			}
 			else placeTableWidget(group, key);
 			return true;
+#endif
 		}
+		return false;
 	}
 	
 	/*!
@@ -568,53 +2337,90 @@ protected:
 			auto making = std::make_shared<JSONobject>();
 			value.actionData_.preferencesJson = making.get();
 			value.process();
-			actionData_.preferencesJson->getObject()[key] = making;
+			savedValue(key) = making;
 			value.actionData_.preferencesJson = nullptr;
 			return true;
 		}
 		case ActionType::LOADING:
 		{
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				value.actionData_.preferencesJson = found->second.get();
+			JSON* found = loadedValue(key);
+			if (found) {
+				value.actionData_.preferencesJson = found;
 				value.process();
 				value.actionData_.preferencesJson = nullptr;
 				return true;
 			} else return false;
 		}
+		case ActionType::MEASURING:
+			value.actionData_.memory = actionData_.memory;
+			value.process();
+			value.actionData_.memory = nullptr;
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
 		case ActionType::GUItable:
-			QGroupBox* group = new QGroupBox(QString::fromStdString(key + ":"));
-			QVBoxLayout* subLayout = new QVBoxLayout();
-			group->setLayout(subLayout);
-			QFrame* innerFrame = new QFrame;
-			QGridLayout* innerLayout = new QGridLayout;
-			innerFrame->setLayout(innerLayout);
-			subLayout->addWidget(innerFrame);
-			value.makeGUI(innerLayout, 0, 0, actionData_.guiInfo->callback);
+			QWidget* group;
+			GUImakingInfo inherited = *actionData_.guiInfo;
+			std::string path = inherited.path + key + "/";
+			if (inherited.lazy) {
+				group = makeCollapsible(key + ":", [&value, inherited, path] (QGridLayout* contents) {
+					value.makeInheritedGUI(ActionType::GUI, contents, 0, 0, inherited, path);
+				});
+			} else {
+				group = new QGroupBox(QString::fromStdString(key + ":"));
+				QVBoxLayout* subLayout = new QVBoxLayout();
+				group->setLayout(subLayout);
+				QFrame* innerFrame = new QFrame;
+				QGridLayout* innerLayout = new QGridLayout;
+				innerFrame->setLayout(innerLayout);
+				subLayout->addWidget(innerFrame);
+				value.makeInheritedGUI(ActionType::GUI, innerLayout, 0, 0, inherited, path);
+			}
 			if (action_ == ActionType::GUI) {
 				actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
 				actionData_.guiInfo->gridDown++;
 			}
 			else placeTableWidget(group, key);
 			return true;
+#endif
 		}
+		return false;
 	}
 	
 	/*!
 	* \brief Saves or loads a vector of objects derived from QuickPreferences
 	* \param The name of the value in the output/input file
 	* \param Reference to the vector
+	* \param If true, it's saved by columns, as an object with the number of elements and an array for each key
 	* \return false if the value was absent while reading, true otherwise
 	*
 	* \note Class must be default constructible
+	* \note Both layouts are recognised when loading, regardless of the columnar argument
+	* \note The columnar layout is smaller and faster to load if the elements synch the same keys, missing values are saved as nulls
 	*/
 	template<typename T>
 	typename std::enable_if<std::is_base_of<QuickPreferences, T>::value, bool>::type
-	synch(const std::string& key, std::vector<T>& value) {
+	synch(const std::string& key, std::vector<T>& value, bool columnar = false) {
 		switch (action_) {
 		case ActionType::SAVING:
 		{
+			if (columnar) {
+				auto making = std::make_shared<JSONwholeObject>();
+				making->memberSlot("count", savingKeys()) = std::make_shared<JSONdouble>(value.size());
+				std::shared_ptr<JSON>& columns = making->memberSlot("columns", savingKeys());
+				columns = std::make_shared<JSONobject>();
+				JSONcolumns rows(columns.get());
+				for (unsigned int i = 0; i < value.size(); i++) {
+					rows.select(i);
+					value[i].action_ = ActionType::SAVING;
+					value[i].actionData_.preferencesJson = &rows;
+					value[i].process();
+					value[i].actionData_.preferencesJson = nullptr;
+				}
+				rows.finish(value.size());
+				savedValue(key) = making;
+				return true;
+			}
 			auto making = std::make_shared<JSONarray>();
 			for (unsigned int i = 0; i < value.size(); i++) {
 				auto innerMaking = std::make_shared<JSONobject>();
@@ -624,19 +2430,51 @@ protected:
 				value[i].actionData_.preferencesJson = nullptr;
 				making->getVector().push_back(innerMaking);
 			}
-			actionData_.preferencesJson->getObject()[key] = making;
+			savedValue(key) = making;
 			return true;
 		}
 		case ActionType::LOADING:
 		{
-			value.clear();
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				for (unsigned int i = 0; i < found->second->getVector().size(); i++) {
+			JSON* found = loadedValue(key);
+			if (found)
+				value.clear();
+			if (found && found->type() == JSONtype::OBJECT) {
+				JSON* count = found->findMember("count");
+				JSON* columns = found->findMember("columns");
+				if (!count || !columns) throw(std::runtime_error("Vector " + key + " is neither an array nor stored by columns"));
+				double counted = count->getDouble();
+				if (!(counted >= 0 && counted <= 9007199254740992.0) || counted != std::floor(counted))
+					throw(std::runtime_error("Vector " + key + " has an invalid count of elements"));
+				size_t size = size_t(counted);
+				// Columns are written with all elements, so the count can't be larger than the longest one
+				size_t longest = 0;
+				for (auto& it : columns->getObject()) {
+					JSONarray* column = dynamic_cast<JSONarray*>(it.second.get());
+					if (column)
+						longest = std::max(longest, std::max(column->contents_.size(), column->numbers_.size()));
+				}
+				if (size > longest)
+					throw(std::runtime_error("Vector " + key + " has fewer elements in its columns than its count"));
+				JSONcolumns rows(columns);
+				value.reserve(size);
+				for (unsigned int i = 0; i < size; i++) {
+					value.push_back(T());
+					T& filled = value.back();
+					rows.select(i);
+					filled.action_ = ActionType::LOADING;
+					filled.actionData_.preferencesJson = &rows;
+					filled.process();
+					filled.actionData_.preferencesJson = nullptr;
+				}
+				return true;
+			} else if (found) {
+				LoadingKeysScope keys;
+				for (unsigned int i = 0; i < found->getVector().size(); i++) {
 					value.push_back(T());
 					T& filled = value.back();
+					keys.nextElement();
 					filled.action_ = ActionType::LOADING;
-					filled.actionData_.preferencesJson = found->second->getVector()[i].get();
+					filled.actionData_.preferencesJson = found->getVector()[i].get();
 					filled.process();
 					filled.actionData_.preferencesJson = nullptr;
 					filled.actionData_.preferencesJson = nullptr;
@@ -644,155 +2482,488 @@ protected:
 				return true;
 			} else return false;
 		}
+		case ActionType::MEASURING:
+			actionData_.memory->usage.objects += containerHeap(value);
+			for (unsigned int i = 0; i < value.size(); i++) {
+				value[i].action_ = ActionType::MEASURING;
+				value[i].actionData_.memory = actionData_.memory;
+				value[i].process();
+				value[i].actionData_.memory = nullptr;
+			}
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
 		{
-			QWidget* group = new QGroupBox(QString::fromStdString(key + ":"));
-			QVBoxLayout* subLayout = new QVBoxLayout();
-			group->setLayout(subLayout);
-			QFrame* innerFrame = new QFrame;
-			subLayout->addWidget(innerFrame);
-			// Note about the strange shared_ptr to unique_ptr: the lambda cannot capture its own shared pointer or it will be never destroyed
-			std::shared_ptr<std::unique_ptr<std::function<void()>>> regenerateTable = std::make_shared<std::unique_ptr<std::function<void()>>>();
-			std::unique_ptr<std::function<void()>>* regenerateSafe = regenerateTable.get();
-			std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
-			(*regenerateSafe) = std::unique_ptr<std::function<void()>>(new std::function<void()>([innerFrame, &value, regenerateSafe, callback] () {
-				// There is no function to clear everything in a layout
-				if (innerFrame->layout()) {
-					qDeleteAll(innerFrame->children());
-					delete innerFrame->layout();
-				}
-				QGridLayout* innerLayout = new QGridLayout;
-				innerFrame->setLayout(innerLayout);
-				int subGridDown = 1;
-				int deletePosition = 0;
-				for (auto it = value.begin(); it != value.end(); ++it) {
-					innerLayout->addWidget(new QLabel(QString::number(subGridDown)), subGridDown, 0);
-					it->makeGUItable(innerLayout, subGridDown, 1, callback);
-					QPushButton* deleteButton = new QPushButton(QPushButton::tr("Delete"));
-					if (!deletePosition)
-						deletePosition = innerLayout->columnCount();
-					innerLayout->addWidget(deleteButton, subGridDown, deletePosition);
-					QObject::connect(deleteButton, &QPushButton::clicked, deleteButton, [&value, it, regenerateSafe, callback]() {
-						value.erase(it);
-						if (callback) (*callback)();
-						(**regenerateSafe)();
-					});
-					subGridDown++;
+			GUImakingInfo inherited = *actionData_.guiInfo;
+			std::string path = inherited.path + key + "/";
+			std::function<void()> notify = changeNotifier(key);
+			auto fill = [&value, inherited, path, notify] (QGridLayout* subLayout) {
+				QFrame* innerFrame = new QFrame;
+				subLayout->addWidget(innerFrame, 0, 0);
+				// Note about the strange shared_ptr to unique_ptr: the lambda cannot capture its own shared pointer or it will be never destroyed
+				std::shared_ptr<std::unique_ptr<std::function<void()>>> regenerateTable = std::make_shared<std::unique_ptr<std::function<void()>>>();
+				std::unique_ptr<std::function<void()>>* regenerateSafe = regenerateTable.get();
+				(*regenerateSafe) = std::unique_ptr<std::function<void()>>(new std::function<void()>([innerFrame, &value, regenerateSafe, inherited, path, notify] () {
+					// There is no function to clear everything in a layout
+					if (innerFrame->layout()) {
+						qDeleteAll(innerFrame->children());
+						delete innerFrame->layout();
+					}
+					QGridLayout* innerLayout = new QGridLayout;
+					innerFrame->setLayout(innerLayout);
+					int subGridDown = 1;
+					int deletePosition = 0;
+					for (auto it = value.begin(); it != value.end(); ++it) {
+						innerLayout->addWidget(new QLabel(QString::number(subGridDown)), subGridDown, 0);
+						it->makeInheritedGUI(ActionType::GUItable, innerLayout, subGridDown, 1, inherited, path + std::to_string(subGridDown - 1) + "/");
+						QPushButton* deleteButton = new QPushButton(QPushButton::tr("Delete"));
+						if (!deletePosition)
+							deletePosition = innerLayout->columnCount();
+						innerLayout->addWidget(deleteButton, subGridDown, deletePosition);
+						QObject::connect(deleteButton, &QPushButton::clicked, deleteButton, [&value, it, regenerateSafe, notify]() {
+							value.erase(it);
+							notify();
+							(**regenerateSafe)();
+						});
+						subGridDown++;
+					}
+				}));
+				(**regenerateTable)();
+				QPushButton* addButton = new QPushButton(QPushButton::tr("Add"));
+				QObject::connect(addButton, &QPushButton::clicked, addButton, [&value, regenerateTable, notify]() {
+					value.emplace_back();
+					notify();
+					(**regenerateTable)();
+				});
+				subLayout->addWidget(addButton, 1, 0);
+			};
+			QWidget* group;
+			if (inherited.lazy)
+				group = makeCollapsible(key + ":", fill);
+			else {
+				group = new QGroupBox(QString::fromStdString(key + ":"));
+				QGridLayout* subLayout = new QGridLayout();
+				group->setLayout(subLayout);
+				fill(subLayout);
+			}
+			actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
+			actionData_.guiInfo->gridDown++;
+			return true;
+		}
+		case ActionType::GUItable:
+			throw(std::logic_error("GUItable can't be called on vectors"));
+#endif
+		}
+		return false;
+	}
+	
+	/*!
+	* \brief Saves or loads a vector of smart pointers to objects derived from QuickPreferences
+	* \param The name of the value in the output/input file
+	* \param Reference to the vector
+	* \return false if the value was absent while reading, true otherwise
+	*
+	* \note The smart pointer class must be dereferencable through operator*() and constructible from raw pointer to the class
+	* \note The class must be default constructible
+	* \note Using a vector of raw pointers may cause memory leaks if there is some content before loading
+	*/
+	template<typename T>
+	typename std::enable_if<std::is_base_of<QuickPreferences, typename std::remove_reference<decltype(*std::declval<T>())>::type>::value
+			&& std::is_constructible<T, typename std::remove_reference<decltype(*std::declval<T>())>::type*>::value, bool>::type
+	synch(const std::string& key, std::vector<T>& value) {
+		switch (action_) {
+		case ActionType::SAVING:
+		{
+			auto making = std::make_shared<JSONarray>();
+			for (unsigned int i = 0; i < value.size(); i++) {
+				auto innerMaking = std::make_shared<JSONobject>();
+				(*value[i]).action_ = ActionType::SAVING;
+				(*value[i]).actionData_.preferencesJson = innerMaking.get();
+				(*value[i]).process();
+				(*value[i]).actionData_.preferencesJson = nullptr;
+				making->getVector().push_back(innerMaking);
+			}
+			savedValue(key) = making;
+			return true;
+		}
+		case ActionType::LOADING:
+		{
+			JSON* found = loadedValue(key);
+			if (found) {
+				value.clear();
+				LoadingKeysScope keys;
+				for (unsigned int i = 0; i < found->getVector().size(); i++) {
+					value.emplace_back(new typename std::remove_reference<decltype(*std::declval<T>())>::type());
+					T& filled = value.back();
+					keys.nextElement();
+					(*value[i]).action_ = ActionType::LOADING;
+					(*filled).actionData_.preferencesJson = found->getVector()[i].get();
+					(*filled).process();
+					(*filled).actionData_.preferencesJson = nullptr;
 				}
-			}));
-			(**regenerateTable)();
-			QPushButton* addButton = new QPushButton(QPushButton::tr("Add"));
-			QObject::connect(addButton, &QPushButton::clicked, addButton, [&value, regenerateTable, callback]() {
-				value.emplace_back();
-				if (callback) (*callback)();
+				return true;
+			} else return false;
+		}
+		case ActionType::MEASURING:
+			actionData_.memory->usage.containers += containerHeap(value);
+			for (unsigned int i = 0; i < value.size(); i++) {
+				if (!value[i])
+					continue;
+				actionData_.memory->usage.objects += sizeof(typename std::remove_reference<decltype(*std::declval<T>())>::type);
+				(*value[i]).action_ = ActionType::MEASURING;
+				(*value[i]).actionData_.memory = actionData_.memory;
+				(*value[i]).process();
+				(*value[i]).actionData_.memory = nullptr;
+			}
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
+		case ActionType::GUI:
+		{
+			GUImakingInfo inherited = *actionData_.guiInfo;
+			std::string path = inherited.path + key + "/";
+			std::function<void()> notify = changeNotifier(key);
+			auto fill = [&value, inherited, path, notify] (QGridLayout* subLayout) {
+				QFrame* innerFrame = new QFrame;
+				subLayout->addWidget(innerFrame, 0, 0);
+				// Note about the strange shared_ptr to unique_ptr: the lambda cannot capture its own shared pointer or it will be never destroyed
+				std::shared_ptr<std::unique_ptr<std::function<void()>>> regenerateTable = std::make_shared<std::unique_ptr<std::function<void()>>>();
+				std::unique_ptr<std::function<void()>>* regenerateSafe = regenerateTable.get();
+				(*regenerateSafe) = std::unique_ptr<std::function<void()>>(new std::function<void()>([innerFrame, &value, regenerateSafe, inherited, path, notify] () {
+					// There is no function to clear everything in a layout
+					if (innerFrame->layout()) {
+						qDeleteAll(innerFrame->children());
+						delete innerFrame->layout();
+					}
+					QGridLayout* innerLayout = new QGridLayout;
+					innerFrame->setLayout(innerLayout);
+					int subGridDown = 1;
+					int deletePosition = 0;
+					for (auto it = value.begin(); it != value.end(); ++it) {
+						innerLayout->addWidget(new QLabel(QString::number(subGridDown)), subGridDown, 0);
+						(*it)->makeInheritedGUI(ActionType::GUItable, innerLayout, subGridDown, 1, inherited, path + std::to_string(subGridDown - 1) + "/");
+						QPushButton* deleteButton = new QPushButton(QPushButton::tr("Delete"));
+						if (!deletePosition)
+							deletePosition = innerLayout->columnCount();
+						innerLayout->addWidget(deleteButton, subGridDown, deletePosition);
+						QObject::connect(deleteButton, &QPushButton::clicked, deleteButton, [&value, it, regenerateSafe, notify]() {
+							value.erase(it);
+							notify();
+							(**regenerateSafe)();
+						});
+						subGridDown++;
+					}
+				}));
 				(**regenerateTable)();
-			});
-			subLayout->addWidget(addButton);
+				QPushButton* addButton = new QPushButton(QPushButton::tr("Add"));
+				QObject::connect(addButton, &QPushButton::clicked, addButton, [&value, regenerateTable, notify]() {
+					value.emplace_back(new typename std::remove_reference<decltype(*std::declval<T>())>::type());
+					notify();
+					(**regenerateTable)();
+				});
+				subLayout->addWidget(addButton, 1, 0);
+			};
+			QWidget* group;
+			if (inherited.lazy)
+				group = makeCollapsible(key + ":", fill);
+			else {
+				group = new QGroupBox(QString::fromStdString(key + ":"));
+				QGridLayout* subLayout = new QGridLayout();
+				group->setLayout(subLayout);
+				fill(subLayout);
+			}
 			actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
 			actionData_.guiInfo->gridDown++;
 			return true;
 		}
 		case ActionType::GUItable:
-			throw(std::logic_error("GUItable can't be called on vectors"));
+			throw(std::logic_error("GUItable can't be called on vectors"));
+#endif
+		}
+		return false;
+	}
+
+	/*!
+	* \brief Saves or loads a std::vector or std::array of strings, arithmetic types or bools
+	* \param The name of the value in the output/input file
+	* \param Reference to the container
+	* \return false if the value was absent while reading, true otherwise
+	*
+	* \note Arithmetic values are stored in bulk, without a JSON node for every element
+	* \note A std::array keeps its size, surplus elements in the file are ignored and missing ones are not changed
+	* \note The GUI edits the numbers and bools as comma separated values and strings as lines of text
+	*/
+	template<typename T>
+	typename std::enable_if<isScalarSequence<T>::value, bool>::type
+	synch(const std::string& key, T& value) {
+		switch (action_) {
+		case ActionType::SAVING:
+		{
+			auto making = std::make_shared<JSONarray>();
+			sequenceToJSON(value, *making);
+			savedValue(key) = making;
+			return true;
+		}
+		case ActionType::LOADING:
+		{
+			JSON* found = loadedValue(key);
+			if (!found)
+				return false;
+			sequenceFromJSON(*found, value);
+			return true;
+		}
+		case ActionType::MEASURING:
+			actionData_.memory->usage.containers += containerHeap(value);
+			for (auto it = value.begin(); it != value.end(); ++it)
+				actionData_.memory->usage.strings += scalarHeap(*it);
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
+		case ActionType::GUI:
+			actionData_.guiInfo->layout->addWidget(new QLabel(QString::fromStdString(key + ":")), actionData_.guiInfo->gridDown, 0);
+		case ActionType::GUItable:
+			typedef typename T::value_type Element;
+			const char separator = std::is_same<Element, std::string>::value ? '\n' : ',';
+			std::string text;
+			for (auto it = value.begin(); it != value.end(); ++it) {
+				if (it != value.begin())
+					text += (separator == ',') ? ", " : "\n";
+				text += scalarToText(Element(*it));
+			}
+			auto parse = [&value, separator] (const std::string& edited) {
+				std::vector<std::string> parts;
+				std::stringstream in(edited);
+				std::string part;
+				while (std::getline(in, part, separator)) {
+					if (separator == ',') {
+						size_t start = part.find_first_not_of(" \t");
+						part = (start == std::string::npos) ? std::string() : part.substr(start, part.find_last_not_of(" \t") - start + 1);
+					}
+					parts.push_back(part);
+				}
+				size_t size = resizeSequence(value, parts.size());
+				for (size_t i = 0; i < size; i++) {
+					Element element;
+					scalarFromText(parts[i], element);
+					value[i] = std::move(element);
+				}
+			};
+			std::function<void()> notify = changeNotifier(key);
+			QWidget* editor;
+			if (separator == ',') {
+				QLineEdit* line = new QLineEdit(QString::fromStdString(text));
+				QObject::connect(line, &QLineEdit::editingFinished, actionData_.guiInfo->layout, [line, parse, notify]() {
+					parse(line->text().toStdString());
+					notify();
+				});
+				editor = line;
+			} else {
+				QPlainTextEdit* lines = new QPlainTextEdit(QString::fromStdString(text));
+				QObject::connect(lines, &QPlainTextEdit::textChanged, actionData_.guiInfo->layout, [lines, parse, notify]() {
+					parse(lines->toPlainText().toStdString());
+					notify();
+				});
+				editor = lines;
+			}
+			if (action_ == ActionType::GUI) {
+				actionData_.guiInfo->layout->addWidget(editor, actionData_.guiInfo->gridDown, 1);
+				actionData_.guiInfo->gridDown++;
+			}
+			else placeTableWidget(editor, key);
+			return true;
+#endif
+		}
+		return false;
+	}
+
+	/*!
+	* \brief Saves or loads a std::map or std::unordered_map with std::string keys
+	* \param The name of the value in the output/input file
+	* \param Reference to the map
+	* \return false if the value was absent while reading, true otherwise
+	*
+	* \note The values can be of any type supported by synch(), they must be default constructible
+	* \note The map is stored as a JSON object, with the map's keys as its keys
+	*/
+	template<typename T>
+	typename std::enable_if<isStringMap<T>::value, bool>::type
+	synch(const std::string& key, T& value) {
+		switch (action_) {
+		case ActionType::SAVING:
+		{
+			auto making = std::make_shared<JSONwholeObject>();
+			JSON* parent = actionData_.preferencesJson;
+			actionData_.preferencesJson = making.get();
+			for (auto& it : value)
+				synch(it.first, it.second);
+			actionData_.preferencesJson = parent;
+			savedValue(key) = making;
+			return true;
+		}
+		case ActionType::LOADING:
+		{
+			JSON* found = loadedValue(key);
+			if (!found)
+				return false;
+			value.clear();
+			JSON* parent = actionData_.preferencesJson;
+			actionData_.preferencesJson = found;
+			for (auto& it : found->getObject())
+				synch(it.first, value[it.first]);
+			actionData_.preferencesJson = parent;
+			return true;
+		}
+		case ActionType::MEASURING:
+			actionData_.memory->usage.containers += containerHeap(value);
+			for (auto& it : value) {
+				actionData_.memory->usage.strings += stringHeap(it.first);
+				synch(it.first, it.second);
+			}
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
+		case ActionType::GUI:
+		case ActionType::GUItable:
+			GUImakingInfo inherited = *actionData_.guiInfo;
+			std::string path = inherited.path + key + "/";
+			auto fill = [this, &value, inherited, path] (QGridLayout* contents) {
+				fillGUI(contents, inherited, path, [this, &value] () {
+					for (auto& it : value)
+						synch(it.first, it.second);
+				});
+			};
+			QWidget* group;
+			if (inherited.lazy)
+				group = makeCollapsible(key + ":", fill);
+			else {
+				group = new QGroupBox(QString::fromStdString(key + ":"));
+				QGridLayout* contents = new QGridLayout();
+				group->setLayout(contents);
+				fill(contents);
+			}
+			if (action_ == ActionType::GUI) {
+				actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
+				actionData_.guiInfo->gridDown++;
+			}
+			else placeTableWidget(group, key);
+			return true;
+#endif
 		}
+		return false;
 	}
-	
+
 	/*!
-	* \brief Saves or loads a vector of smart pointers to objects derived from QuickPreferences
+	* \brief Saves or loads a string, arithmetic value or bool held in a pointer
 	* \param The name of the value in the output/input file
-	* \param Reference to the vector
+	* \param Reference to the pointer
 	* \return false if the value was absent while reading, true otherwise
 	*
-	* \note The smart pointer class must be dereferencable through operator*() and constructible from raw pointer to the class
-	* \note The class must be default constructible
-	* \note Using a vector of raw pointers may cause memory leaks if there is some content before loading
+	* \note A null pointer is saved as null, the pointer must be constructible from a raw pointer
+	* \note If not null, the contents will be overwritten, so raw pointers must be initalised before calling it, but no memory leak will occur
+	* \note If a std::shared_ptr shares its value with another pointer, it's given its own copy to overwrite
 	*/
 	template<typename T>
-	typename std::enable_if<std::is_base_of<QuickPreferences, typename std::remove_reference<decltype(*std::declval<T>())>::type>::value
+	typename std::enable_if<isScalar<typename std::remove_reference<decltype(*std::declval<T>())>::type>::value
 			&& std::is_constructible<T, typename std::remove_reference<decltype(*std::declval<T>())>::type*>::value, bool>::type
-	synch(const std::string& key, std::vector<T>& value) {
+	synch(const std::string& key, T& value) {
+		typedef typename std::remove_reference<decltype(*std::declval<T>())>::type Element;
 		switch (action_) {
 		case ActionType::SAVING:
-		{
-			auto making = std::make_shared<JSONarray>();
-			for (unsigned int i = 0; i < value.size(); i++) {
-				auto innerMaking = std::make_shared<JSONobject>();
-				(*value[i]).action_ = ActionType::SAVING;
-				(*value[i]).actionData_.preferencesJson = innerMaking.get();
-				(*value[i]).process();
-				(*value[i]).actionData_.preferencesJson = nullptr;
-				making->getVector().push_back(innerMaking);
-			}
-			actionData_.preferencesJson->getObject()[key] = making;
+			if (!value)
+				savedValue(key) = std::make_shared<JSON>();
+			else
+				synch(key, *value);
 			return true;
-		}
 		case ActionType::LOADING:
 		{
-			value.clear();
-			auto found = actionData_.preferencesJson->getObject().find(key);
-			if (found != actionData_.preferencesJson->getObject().end()) {
-				for (unsigned int i = 0; i < found->second->getVector().size(); i++) {
-					value.emplace_back(new typename std::remove_reference<decltype(*std::declval<T>())>::type());
-					T& filled = value.back();
-					(*value[i]).action_ = ActionType::LOADING;
-					(*filled).actionData_.preferencesJson = found->second->getVector()[i].get();
-					(*filled).process();
-					(*filled).actionData_.preferencesJson = nullptr;
-				}
-				return true;
-			} else return false;
+			JSON* found = loadedValue(key);
+			if (!found)
+				return false;
+			if (found->type() != JSONtype::NIL) {
+				if (!value)
+					value = T(new Element());
+				else
+					unsharePointee(value);
+				synch(key, *value);
+			} else
+				value = nullptr;
+			return true;
 		}
+		case ActionType::MEASURING:
+			if (value) {
+				actionData_.memory->usage.objects += sizeof(Element);
+				synch(key, *value);
+			}
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
 		case ActionType::GUI:
-		{
-			QWidget* group = new QGroupBox(QString::fromStdString(key + ":"));
-			QVBoxLayout* subLayout = new QVBoxLayout();
-			group->setLayout(subLayout);
-			QFrame* innerFrame = new QFrame;
-			subLayout->addWidget(innerFrame);
-			// Note about the strange shared_ptr to unique_ptr: the lambda cannot capture its own shared pointer or it will be never destroyed
-			std::shared_ptr<std::unique_ptr<std::function<void()>>> regenerateTable = std::make_shared<std::unique_ptr<std::function<void()>>>();
-			std::unique_ptr<std::function<void()>>* regenerateSafe = regenerateTable.get();
-			std::shared_ptr<std::function<void()>> callback = actionData_.guiInfo->callback;
-			(*regenerateSafe) = std::unique_ptr<std::function<void()>>(new std::function<void()>([innerFrame, &value, regenerateSafe, callback] () {
-				// There is no function to clear everything in a layout
-				if (innerFrame->layout()) {
-					qDeleteAll(innerFrame->children());
-					delete innerFrame->layout();
-				}
-				QGridLayout* innerLayout = new QGridLayout;
-				innerFrame->setLayout(innerLayout);
-				int subGridDown = 1;
-				int deletePosition = 0;
-				for (auto it = value.begin(); it != value.end(); ++it) {
-					innerLayout->addWidget(new QLabel(QString::number(subGridDown)), subGridDown, 0);
-					(*it)->makeGUItable(innerLayout, subGridDown, 1, callback);
-					QPushButton* deleteButton = new QPushButton(QPushButton::tr("Delete"));
-					if (!deletePosition)
-						deletePosition = innerLayout->columnCount();
-					innerLayout->addWidget(deleteButton, subGridDown, deletePosition);
-					QObject::connect(deleteButton, &QPushButton::clicked, deleteButton, [&value, it, regenerateSafe, callback]() {
-						value.erase(it);
-						if (callback) (*callback)();
-						(**regenerateSafe)();
-					});
-					subGridDown++;
+		case ActionType::GUItable:
+			QGroupBox* group = new QGroupBox(QString::fromStdString((action_ == ActionType::GUI) ? key : ""));
+			group->setCheckable(true);
+			group->setChecked(bool(value));
+			group->setLayout(new QGridLayout);
+			GUImakingInfo inherited = *actionData_.guiInfo;
+			std::function<void()> notify = changeNotifier(key);
+			auto fill = [this, &value, group, inherited, key] () {
+				fillGUI(static_cast<QGridLayout*>(group->layout()), inherited, inherited.path, [this, &value, key] () {
+					synch(key, *value);
+				});
+			};
+			if (value)
+				fill();
+			QObject::connect(group, &QGroupBox::clicked, group, [&value, group, fill, notify]() {
+				if (group->isChecked()) {
+					value = T(new Element());
+					fill();
+				} else {
+					qDeleteAll(group->children());
+					delete group->layout();
+					group->setLayout(new QGridLayout);
+					value = nullptr;
 				}
-			}));
-			(**regenerateTable)();
-			QPushButton* addButton = new QPushButton(QPushButton::tr("Add"));
-			QObject::connect(addButton, &QPushButton::clicked, addButton, [&value, regenerateTable, callback]() {
-				value.emplace_back(new typename std::remove_reference<decltype(*std::declval<T>())>::type());
-				if (callback) (*callback)();
-				(**regenerateTable)();
+				notify();
 			});
-			subLayout->addWidget(addButton);
-			actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
-			actionData_.guiInfo->gridDown++;
+			if (action_ == ActionType::GUI) {
+				actionData_.guiInfo->layout->addWidget(group, actionData_.guiInfo->gridDown, 0, 1, 2);
+				actionData_.guiInfo->gridDown++;
+			}
+			else placeTableWidget(group, key);
 			return true;
+#endif
 		}
+		return false;
+	}
+
+	/*!
+	* \brief Saves or loads a value held in a CopyOnWrite wrapper
+	* \param The name of the value in the output/input file
+	* \param Reference to the wrapper
+	* \return false if the value was absent while reading, true otherwise
+	*
+	* \note The value is copied before loading only if it's present in the file and shared
+	* \note The GUI edits a private copy, made when the GUI is created
+	* \note Saving or measuring a shared object derived from QuickPreferences changes its internal state, it isn't thread-safe
+	*/
+	template<typename T>
+	bool synch(const std::string& key, CopyOnWrite<T>& value) {
+		switch (action_) {
+		case ActionType::SAVING:
+			return synch(key, const_cast<T&>(*value));
+		case ActionType::LOADING:
+			if (!loadedValue(key))
+				return false;
+			return synch(key, value.edit());
+		case ActionType::MEASURING:
+			// Values shared by multiple objects are counted once
+			if (actionData_.memory->counted.insert(&*value).second) {
+				actionData_.memory->usage.objects += sizeof(T);
+				synch(key, const_cast<T&>(*value));
+			}
+			return true;
+#ifndef QUICK_PREFERENCES_NO_GUI
+		case ActionType::GUI:
 		case ActionType::GUItable:
-			throw(std::logic_error("GUItable can't be called on vectors"));
+			return synch(key, value.edit());
+#endif
 		}
+		return false;
 	}
 
 public:
@@ -804,14 +2975,17 @@ public:
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	inline std::string serialise() const {
+		SavingKeysScope keys;
 		std::shared_ptr<JSON> target = std::make_shared<JSONobject>();
 		actionData_.preferencesJson = target.get();
 		action_ = ActionType::SAVING;
 		const_cast<QuickPreferences*>(this)->process();
-		std::stringstream out;
-		actionData_.preferencesJson->write(out);
+		std::string out;
+		JSONwriter writer(out);
+		actionData_.preferencesJson->write(writer);
 		actionData_.preferencesJson = nullptr;
-		return out.str();
+		recordPeakMemory(*target, out.capacity());
+		return out;
 	}
 
 	/*!
@@ -822,12 +2996,51 @@ public:
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	inline void save(const std::string& fileName) const {
+		SavingKeysScope keys;
 		std::shared_ptr<JSON> target = std::make_shared<JSONobject>();
 		actionData_.preferencesJson = target.get();
 		action_ = ActionType::SAVING;
 		const_cast<QuickPreferences*>(this)->process();
-		actionData_.preferencesJson->writeToFile(fileName);
+		size_t buffers = actionData_.preferencesJson->writeToFile(fileName);
 		actionData_.preferencesJson = nullptr;
+		recordPeakMemory(*target, buffers);
+	}
+
+	/*!
+	* \brief Serialises only the values that differ from another object, to be loaded over a copy of it
+	* \param The object with the values of the lower layer, usually the defaults
+	* \return The JSON string
+	*
+	* \note Nested objects are compared key by key, other values, including vectors and maps, are saved whole if they differ
+	* \note It calls the overloaded process() method of both objects
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline std::string serialise(const QuickPreferences& base) const {
+		std::shared_ptr<JSON> original;
+		std::shared_ptr<JSON> modified;
+		std::shared_ptr<JSON> difference = differenceFrom(base, original, modified);
+		std::string out;
+		JSONwriter writer(out);
+		difference->write(writer);
+		recordPeakMemory({ original.get(), modified.get(), difference.get() }, out.capacity());
+		return out;
+	}
+
+	/*!
+	* \brief Saves only the values that differ from another object to a JSON file, to be loaded over a copy of it
+	* \param The name of the JSON file
+	* \param The object with the values of the lower layer, usually the defaults
+	*
+	* \note Nested objects are compared key by key, other values, including vectors and maps, are saved whole if they differ
+	* \note It calls the overloaded process() method of both objects
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline void save(const std::string& fileName, const QuickPreferences& base) const {
+		std::shared_ptr<JSON> original;
+		std::shared_ptr<JSON> modified;
+		std::shared_ptr<JSON> difference = differenceFrom(base, original, modified);
+		size_t buffers = difference->writeToFile(fileName);
+		recordPeakMemory({ original.get(), modified.get(), difference.get() }, buffers);
 	}
 
 	/*!
@@ -839,16 +3052,22 @@ public:
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	inline void deserialise(const std::string& source) {
-		std::stringstream sourceStream(source);
-		std::shared_ptr<JSON> target = parseJSON(source);
-		actionData_.preferencesJson = target.get();
-		if (actionData_.preferencesJson->type() == JSONtype::NIL) {
-			actionData_.preferencesJson = nullptr;
-			return;
-		}
-		action_ = ActionType::LOADING;
-		process();
-		actionData_.preferencesJson = nullptr;
+		KeyTable keys;
+		std::shared_ptr<JSON> target = parseJSON(source.data(), source.data() + source.size(), keys, true);
+		recordPeakMemory(*target, source.capacity());
+		loadFromJSON(*target);
+	}
+
+	/*!
+	* \brief Loads the object from an already parsed JSON structure, for example from a JSONpushParser
+	* \param The structure
+	*
+	* \note It calls the overloaded process() method
+	* \note If the structure is null, nothing is done
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline void deserialise(JSON& source) {
+		loadFromJSON(source);
 	}
 
 	/*!
@@ -860,17 +3079,274 @@ public:
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	inline void load(const std::string& fileName) {
-		std::shared_ptr<JSON> target = parseJSON(fileName);
-		actionData_.preferencesJson = target.get();
-		if (actionData_.preferencesJson->type() == JSONtype::NIL) {
-			actionData_.preferencesJson = nullptr;
-			return;
+		// Strings in the structure refer to the buffer, so they are copied only when they are assigned to the members
+		std::string buffer;
+		if (!readFile(fileName, buffer)) return;
+		KeyTable keys;
+		std::shared_ptr<JSON> target = parseJSON(buffer.data(), buffer.data() + buffer.size(), keys, true);
+		recordPeakMemory(*target, buffer.capacity());
+		loadFromJSON(*target);
+	}
+
+	/*!
+	* \brief Loads the object from a JSON file if it changed since the last time it was loaded
+	* \param The name of the JSON file
+	* \param The state of the file at the last load, it's updated by the call
+	* \return true if the object was loaded, false if the file didn't change or cannot be read
+	*
+	* \note If the file's size, modification time and inode are the same, the file is not even read
+	* \note If only the metadata changed, the file is read, but not parsed if the hash of its contents is the same
+	* \note It calls the overloaded process() method if the file changed
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline bool load(const std::string& fileName, FileStamp& stamp) {
+		// The metadata are read first, so that a change made during reading is noticed next time
+		FileStamp current;
+		if (!current.read(fileName))
+			return false;
+		if (stamp.sameFile(current))
+			return false;
+		std::string buffer;
+		if (!readFile(fileName, buffer))
+			return false;
+		current.hash = contentHash(buffer.data(), buffer.size());
+		current.valid = true;
+		bool changed = !stamp.valid || stamp.hash != current.hash;
+		if (changed) {
+			KeyTable keys;
+			std::shared_ptr<JSON> target = parseJSON(buffer.data(), buffer.data() + buffer.size(), keys, true);
+			recordPeakMemory(*target, buffer.capacity());
+			loadFromJSON(*target);
 		}
-		action_ = ActionType::LOADING;
-		process();
-		actionData_.preferencesJson = nullptr;
+		stamp = current;
+		return changed;
+	}
+
+	/*!
+	* \brief Computes the memory used by the object's members, as visited by process()
+	* \return The memory usage
+	*
+	* \note The object itself is not included, only what it owns, nested objects held by value are part of it
+	* \note It calls the overloaded process() method
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline MemoryUsage memoryUsage() const {
+		MemoryCounter counter;
+		actionData_.memory = &counter;
+		action_ = ActionType::MEASURING;
+		const_cast<QuickPreferences*>(this)->process();
+		actionData_.memory = nullptr;
+		return counter.usage;
+	}
+
+	/*!
+	* \brief Computes the memory used by a JSON structure
+	* \param The root of the structure
+	* \return The memory usage, with counts of nodes of each type
+	*
+	* \note Nodes and keys referred to from multiple places are counted once
+	* \note Arrays of numbers stored in bulk have no nodes for their elements
+	*/
+	static MemoryUsage memoryUsage(JSON& structure) {
+		MemoryCounter counter;
+		structure.measure(counter);
+		return counter.usage;
+	}
+
+	/*!
+	* \brief Enables recording the memory used while loading or saving on this thread
+	* \param Whether it should be recorded
+	*
+	* \note It needs to traverse the whole JSON structure, so it's disabled by default
+	*/
+	static void trackPeakMemory(bool enabled = true) {
+		peakMemory().tracking = enabled;
+	}
+
+	/*!
+	* \brief Returns the memory used by the JSON structures and the buffers at the peak of the last load or save on this thread
+	* \return The memory usage
+	*
+	* \note Only load(), save(), serialise() and deserialise(), including those of Serialiser and ParsedFile::applyTo(), are tracked
+	* and only if enabled with trackPeakMemory()
+	* \note The buffers include the text and the buffers for writing and compressing, but not the compression library's own state
+	*/
+	static MemoryUsage lastPeakMemory() {
+		return peakMemory().last;
+	}
+
+	/*!
+	* \brief Serialises and deserialises many objects, keeping its buffers and interned keys between the calls
+	*
+	* \note The returned strings are valid until the next call
+	* \note Keys are interned for the lifetime of the serialiser, so a map with ever changing keys will make it grow
+	* \note Not thread-safe, each thread needs its own
+	*/
+	class Serialiser {
+		KeyTable keys_;
+		std::shared_ptr<JSONobject> root_;
+		std::string output_;
+		JSONwriter out_;
+
+		void write(const QuickPreferences& object, int depth) {
+			SavingKeysScope scope(keys_);
+			root_->contents_.clear();
+			object.actionData_.preferencesJson = root_.get();
+			object.action_ = ActionType::SAVING;
+			const_cast<QuickPreferences&>(object).process();
+			object.actionData_.preferencesJson = nullptr;
+			root_->write(out_, depth);
+			// Only one object is held at a time, so the largest one makes the peak of a range
+			recordPeakMemory({ root_.get() }, output_.capacity(), depth > 0);
+		}
+
+	public:
+		Serialiser() : root_(std::make_shared<JSONobject>()), out_(output_) {}
+		Serialiser(const Serialiser&) = delete;
+
+		/*!
+		* \brief Serialises an object to a JSON string
+		* \param The object
+		* \return The JSON string, valid until the next call
+		*
+		* \note It calls the overloaded process() method
+		*/
+		const std::string& serialise(const QuickPreferences& object) {
+			output_.clear();
+			write(object, 0);
+			return output_;
+		}
+
+		/*!
+		* \brief Serialises a range of objects to a JSON array
+		* \param Iterator to the first object
+		* \param Iterator past the last object
+		* \return The JSON string, valid until the next call
+		*
+		* \note It calls the overloaded process() method of each object
+		*/
+		template <typename Iterator>
+		const std::string& serialise(Iterator begin, Iterator end) {
+			output_.clear();
+			if (peakMemory().tracking)
+				peakMemory().last = MemoryUsage();
+			output_.push_back('[');
+			for (Iterator it = begin; it != end; ++it) {
+				output_.append((it == begin) ? "\n\t" : ",\n\t");
+				write(*it, 1);
+			}
+			output_.append((begin == end) ? "]" : "\n]");
+			return output_;
+		}
+
+		/*!
+		* \brief Loads an object from a JSON string
+		* \param The JSON string
+		* \param The object to fill
+		*
+		* \note It calls the overloaded process() method
+		*/
+		void deserialise(const std::string& source, QuickPreferences& target) {
+			std::shared_ptr<JSON> parsed = parseJSON(source.data(), source.data() + source.size(), keys_, true);
+			recordPeakMemory(*parsed, source.capacity());
+			target.loadFromJSON(*parsed);
+		}
+
+		/*!
+		* \brief Loads a vector of objects from a JSON array
+		* \param The JSON string
+		* \param The vector to fill, its previous contents are removed
+		*
+		* \note It calls the overloaded process() method of each object
+		*/
+		template <typename T>
+		void deserialise(const std::string& source, std::vector<T>& target) {
+			std::shared_ptr<JSON> parsed = parseJSON(source.data(), source.data() + source.size(), keys_, true);
+			recordPeakMemory(*parsed, source.capacity());
+			std::vector<std::shared_ptr<JSON>>& elements = parsed->getVector();
+			target.clear();
+			target.reserve(elements.size());
+			LoadingKeysScope keys;
+			for (auto& it : elements) {
+				target.push_back(T());
+				keys.nextElement();
+				target.back().loadFromJSON(*it);
+			}
+		}
+	};
+
+	/*!
+	* \brief A file read and parsed by loadAsync(), waiting to be applied to an object
+	*
+	* \note It can be applied to any number of objects, applying it from multiple threads at once is safe but not parallel
+	*/
+	class ParsedFile {
+		// The strings in the structure refer to the buffer, so it must not move
+		std::unique_ptr<std::string> buffer_;
+		std::shared_ptr<JSON> structure_;
+		// Loading converts strings and arrays in the structure as they are read, so only one object is loaded at a time
+		std::unique_ptr<std::mutex> applying_;
+
+		friend class QuickPreferences;
+	public:
+		ParsedFile() : buffer_(new std::string()), structure_(std::make_shared<JSON>()), applying_(new std::mutex()) {}
+
+		/*!
+		* \brief Returns if the file could be read
+		*/
+		inline bool valid() const {
+			return structure_->type() != JSONtype::NIL;
+		}
+
+		/*!
+		* \brief Returns the parsed JSON structure, null if the file could not be read
+		*
+		* \note Reading it changes it, so it must not be used while the file is being applied to an object
+		*/
+		inline JSON& structure() const {
+			return *structure_;
+		}
+
+		/*!
+		* \brief Loads an object from the parsed file
+		* \param The object to fill
+		* \return false if the file could not be read, true otherwise
+		*
+		* \note It calls the overloaded process() method
+		* \note It should be called from the thread that owns the object, for example the GUI thread
+		* \note Calls from different threads wait for each other
+		*/
+		bool applyTo(QuickPreferences& target) const {
+			if (!valid())
+				return false;
+			std::lock_guard<std::mutex> lock(*applying_);
+			recordPeakMemory(*structure_, buffer_->capacity());
+			target.loadFromJSON(*structure_);
+			return true;
+		}
+	};
+
+	/*!
+	* \brief Reads and parses a JSON file on a separate thread, to be applied to objects later
+	* \param The name of the JSON file
+	* \return The future parsed file, it's invalid if the file could not be read
+	*
+	* \note The parsed file is applied with ParsedFile::applyTo(), which calls process() on the thread that calls it
+	* \note Any number of files can be loaded at the same time
+	* \note Like any future from std::async, it waits for the thread to finish when destroyed
+	*/
+	static std::future<ParsedFile> loadAsync(const std::string& fileName) {
+		return std::async(std::launch::async, [fileName] () {
+			ParsedFile parsed;
+			if (readFile(fileName, *parsed.buffer_)) {
+				KeyTable keys;
+				parsed.structure_ = parseJSON(parsed.buffer_->data(), parsed.buffer_->data() + parsed.buffer_->size(), keys, true);
+			}
+			return parsed;
+		});
 	}
 
+#ifndef QUICK_PREFERENCES_NO_GUI
 	/*!
 	* \brief Overload this to change the behaviour of all GUI construction of this class, while it appears in the tree
 	* and retains all other functionality
@@ -894,17 +3370,17 @@ public:
 	* \param Optional offset down
 	* \param Optional offset left
 	* \param Optional functor providing callback when anything is changed
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
 	*
 	* \note Overloading this will change the behaviour of all other makeGUI calls
 	* \note It calls the overloaded process() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
-	inline void makeGUI(QGridLayout* layout, int gridDown = 0, int gridRight = 0, std::shared_ptr<std::function<void()>> callback = nullptr) {
-		action_ = ActionType::GUI;
-		std::unique_ptr<GUImakingInfo> info(new GUImakingInfo());
-		actionData_.guiInfo = info.get();
-		constructGUI(layout, gridDown, gridRight, callback);
-		actionData_.guiInfo = nullptr;
+	inline void makeGUI(QGridLayout* layout, int gridDown = 0, int gridRight = 0, std::shared_ptr<std::function<void()>> callback = nullptr, bool lazy = false) {
+		GUImakingInfo settings;
+		settings.callback = callback;
+		settings.lazy = lazy;
+		makeInheritedGUI(ActionType::GUI, layout, gridDown, gridRight, settings, "");
 	}
 
 	/*!
@@ -913,56 +3389,153 @@ public:
 	* \param Optional offset down
 	* \param Optional offset left
 	* \param Optional functor providing callback when anything is changed
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
 	*
 	* \note Overloading this will change the behaviour of all other makeGUI calls
 	* \note It calls the overloaded process() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
-	inline void makeGUItable(QGridLayout* layout, int gridDown = 0, int gridRight = 0, std::shared_ptr<std::function<void()>> callback = nullptr) {
-		action_ = ActionType::GUItable;
-		std::unique_ptr<GUImakingInfo> info(new GUImakingInfo());
-		actionData_.guiInfo = info.get();
-		constructGUI(layout, gridDown, gridRight, callback);
-		actionData_.guiInfo = nullptr;
+	inline void makeGUItable(QGridLayout* layout, int gridDown = 0, int gridRight = 0, std::shared_ptr<std::function<void()>> callback = nullptr, bool lazy = false) {
+		GUImakingInfo settings;
+		settings.callback = callback;
+		settings.lazy = lazy;
+		makeInheritedGUI(ActionType::GUItable, layout, gridDown, gridRight, settings, "");
 	}
 
 	/*!
 	* \brief Fills a QGridLayout using the class
 	* \param The layout to fill
 	* \param Optional functor providing callback when anything is changed
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
 	*
 	* \note It calls the overloaded process() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
-	inline void makeGUI(QGridLayout* layout, int gridDown = 0, int gridRight = 0, std::function<void()> callback = nullptr) {
-		makeGUI(layout, gridDown, gridRight, callback ? std::make_shared<std::function<void()>>(callback) : nullptr);
+	inline void makeGUI(QGridLayout* layout, int gridDown = 0, int gridRight = 0, std::function<void()> callback = nullptr, bool lazy = false) {
+		makeGUI(layout, gridDown, gridRight, callback ? std::make_shared<std::function<void()>>(callback) : nullptr, lazy);
 	}
 
 	/*!
 	* \brief Generates a Qt widget from the class
 	* \param Optional functor providing callback when anything is changed
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
 	*
 	* \note It calls the overloaded process() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
-	inline QWidget* makeGUI(std::function<void()> callback = nullptr) {
-		return makeGUI(callback ? std::make_shared<std::function<void()>>(callback) : nullptr);
+	inline QWidget* makeGUI(std::function<void()> callback = nullptr, bool lazy = false) {
+		return makeGUI(callback ? std::make_shared<std::function<void()>>(callback) : nullptr, lazy);
 	}
 
 	/*!
 	* \brief Generates a Qt widget from the class
 	* \param Optional functor providing callback when anything is changed
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
+	*
+	* \note It calls the overloaded process() method
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline QWidget* makeGUI(std::shared_ptr<std::function<void()>> callback = nullptr, bool lazy = false) {
+		std::unique_ptr<QWidget> retval(new QWidget);
+		std::unique_ptr<QGridLayout> layout(new QGridLayout());
+		makeGUI(layout.get(), 0, 0, callback, lazy);
+		retval->setLayout(layout.release());
+		return retval.release();
+	}
+
+	/*!
+	* \brief Fills a QGridLayout using the class, reporting the changes in batches
+	* \param The layout to fill
+	* \param Offset down
+	* \param Offset left
+	* \param The batch that collects the paths of changed values and reports them together
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
+	*
+	* \note It calls the overloaded process() method
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline void makeGUI(QGridLayout* layout, int gridDown, int gridRight, std::shared_ptr<ChangeBatch> batch, bool lazy = false) {
+		GUImakingInfo settings;
+		settings.batch = batch;
+		settings.lazy = lazy;
+		makeInheritedGUI(ActionType::GUI, layout, gridDown, gridRight, settings, "");
+	}
+
+	/*!
+	* \brief Generates a Qt widget from the class, reporting the changes in batches
+	* \param The batch that collects the paths of changed values and reports them together
+	* \param If true, nested objects are shown as collapsed sections whose widgets are built when first expanded
 	*
 	* \note It calls the overloaded process() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
-	inline QWidget* makeGUI(std::shared_ptr<std::function<void()>> callback = nullptr) {
+	inline QWidget* makeGUI(std::shared_ptr<ChangeBatch> batch, bool lazy = false) {
 		std::unique_ptr<QWidget> retval(new QWidget);
 		std::unique_ptr<QGridLayout> layout(new QGridLayout());
-		makeGUI(layout.get(), 0, 0, callback);
+		makeGUI(layout.get(), 0, 0, batch, lazy);
 		retval->setLayout(layout.release());
 		return retval.release();
 	}
+#endif
+};
+
+/*!
+* \brief Implements process() from a list of members described by the Derived class' static fields() method
+*
+* \note fields() must be a static template method that calls its argument with the result of field() for every member
+* \note Keys are converted to strings and checked for duplicates only once per class, not at every synch() call
+* \note Saving and loading use the hashes of the keys computed at compile time instead of hashing them again
+* \note It can be mixed with other descendants of QuickPreferences and process() can still be overloaded
+*/
+template <typename Derived>
+class QuickPreferencesFields : public QuickPreferences {
+	struct KeyCollector {
+		std::vector<JSONkey> keys;
+
+		template <typename Owner, typename Member>
+		void operator()(const Field<Owner, Member>& described) {
+			for (auto& it : keys)
+				if (it.hash() == described.hash && it.str() == described.name)
+					throw(std::logic_error(std::string("Key ") + described.name + " is described more than once"));
+			keys.emplace_back(std::string(described.name), described.hash);
+		}
+	};
+
+	struct Synchroniser {
+		QuickPreferencesFields& owner;
+		Derived& object;
+		const std::vector<JSONkey>& keys;
+		unsigned int index;
+		const JSONkey* previous;
+
+		Synchroniser(QuickPreferencesFields& owner, const std::vector<JSONkey>& keys) :
+				owner(owner), object(static_cast<Derived&>(owner)), keys(keys), index(0), previous(fieldKey()) {}
+		~Synchroniser() {
+			fieldKey() = previous;
+		}
+
+		template <typename Owner, typename Member>
+		void operator()(const Field<Owner, Member>& described) {
+			const JSONkey& key = keys[index++];
+			fieldKey() = &key;
+			owner.synch(key.str(), object.*described.member);
+		}
+	};
+
+	static const std::vector<JSONkey>& keys() {
+		static const std::vector<JSONkey> collected = [] () {
+			KeyCollector collector;
+			Derived::fields(collector);
+			return collector.keys;
+		}();
+		return collected;
+	}
+
+public:
+	void process() override {
+		Synchroniser synchroniser(*this, keys());
+		Derived::fields(synchroniser);
+	}
 };
 
 #endif //QUICK_PREFERENCES_HPP
@@ -5,12 +5,23 @@ struct Chapter : public QuickPreferences {
 	std::string contents = "";
 	std::string author = "Anonymous";
 
-	virtual void saveOrLoad() {
+	virtual void process() {
 		synch("contents", contents);
 		synch("author", author);
 	}
 };
 
+struct Appendix : public QuickPreferencesFields<Appendix> {
+	std::string title = "";
+	unsigned int pages = 0;
+
+	template <typename Visitor>
+	static void fields(Visitor& visit) {
+		visit(field("title", &Appendix::title));
+		visit(field("pages", &Appendix::pages));
+	}
+};
+
 struct Preferences : public QuickPreferences {
 	std::string lastFolder = "";
 	unsigned int lastOpen = 0;
@@ -20,8 +31,13 @@ struct Preferences : public QuickPreferences {
 	std::vector<std::shared_ptr<Chapter>> footnotes;
 	std::vector<std::unique_ptr<Chapter>> addenda;
 	std::string* editorsNote = nullptr;
+	std::vector<Appendix> appendices;
+	std::vector<Appendix> sources;
+	std::vector<double> calibration;
+	double zoom = 1;
+	std::map<std::string, int> wordCounts;
 
-	virtual void saveOrLoad() {
+	virtual void process() {
 		synch("last_folder", lastFolder);
 		synch("last_open", lastOpen);
 		synch("privileged", privileged);
@@ -30,6 +46,23 @@ struct Preferences : public QuickPreferences {
 		synch("footnotes", footnotes);
 		synch("addenda", addenda);
 		synch("editors_notes", editorsNote);
+		synch("appendices", appendices);
+		synch("sources", sources, true);
+		synch("calibration", calibration);
+		synch("zoom", zoom);
+		synch("word_counts", wordCounts);
+	}
+};
+
+struct Site : public QuickPreferences {
+	unsigned int port = 80;
+	std::vector<Chapter> pages;
+	std::shared_ptr<Chapter> about = std::make_shared<Chapter>();
+
+	virtual void process() {
+		synch("port", port);
+		synch("pages", pages);
+		synch("about", about);
 	}
 };
 
@@ -55,12 +88,114 @@ int main() {
 	testReadJson->getObject()["number"]->getDouble() = 42;
 	testReadJson->writeToFile("test-reread.json");
 
+	std::string pushed = "{\"name\": \"a \\\"quoted\\\" \\u00e9 name\", \"values\": [1.5e3, -20, {\"deep\": [true, null]}], \"count\": 12345}[7] 42";
+	QuickPreferences::JSONpushParser pushParser;
+	size_t fed = 0;
+	while (fed < pushed.size() && !pushParser.feed(pushed.data() + fed, 1))
+		fed++;
+	std::shared_ptr<QuickPreferences::JSON> pushedJson = pushParser.result();
+	bool pushedRight = pushedJson->getObject()["name"]->getString() == "a \"quoted\" \u00e9 name"
+			&& pushedJson->getObject()["values"]->getVector()[0]->getDouble() == 1500
+			&& pushedJson->getObject()["values"]->getVector()[1]->getDouble() == -20
+			&& pushedJson->getObject()["values"]->getVector()[2]->getObject()["deep"]->getVector()[0]->getBool()
+			&& pushedJson->getObject()["count"]->getDouble() == 12345;
+	// The following documents are in one chunk, only the first one is used by the first call
+	const char* rest = pushed.data() + fed + 1;
+	size_t restSize = pushed.size() - fed - 1;
+	pushParser.reset();
+	pushedRight = pushedRight && pushParser.feed(rest, restSize) && pushParser.result()->getVector().size() == 1;
+	rest += pushParser.used();
+	restSize -= pushParser.used();
+	pushParser.reset();
+	pushedRight = pushedRight && !pushParser.feed(rest, restSize) && pushParser.finish() && pushParser.result()->getDouble() == 42;
+	if (!pushedRight) {
+		std::cout << "The push parser parsed the document incorrectly" << std::endl;
+		return 1;
+	}
+
+	QuickPreferences::MemoryUsage jsonMemory = QuickPreferences::memoryUsage(*testReadJson);
+	if (jsonMemory.count(QuickPreferences::JSONtype::OBJECT) != 10) {
+		std::cout << "The parsed JSON has " << jsonMemory.count(QuickPreferences::JSONtype::OBJECT) << " objects instead of 10" << std::endl;
+		return 1;
+	}
+
 	Preferences prefs;
+	QuickPreferences::trackPeakMemory();
 	prefs.load("prefs.json");
 	prefs.footnotes.push_back(std::make_shared<Chapter>());
 	prefs.footnotes.back()->contents = "There will be a lot of footnotes";
 	prefs.footnotes.back()->author = "Dugi";
+	prefs.appendices.emplace_back();
+	prefs.appendices.back().title = "Index";
+	prefs.appendices.back().pages = 3;
+	prefs.sources.resize(2);
+	prefs.sources[0].title = "Letters";
+	prefs.sources[1].pages = 12;
+	prefs.calibration = { 0.5, std::numeric_limits<double>::quiet_NaN(), -3e-5 };
+	prefs.zoom = std::numeric_limits<double>::infinity();
+	prefs.wordCounts["preface"] = 1200;
+	prefs.lastFolder = "C:\\\"Drafts\"\n\t\x01\x1f/";
 	prefs.save("prefs.json");
+	Preferences reloaded;
+	reloaded.load("prefs.json");
+	if (reloaded.serialise() != prefs.serialise() || reloaded.sources.size() != 2 || reloaded.sources[1].pages != 12
+			|| reloaded.appendices.size() != prefs.appendices.size() || prefs.serialise().find("\"columns\"") == std::string::npos
+			|| reloaded.lastFolder != prefs.lastFolder
+			|| reloaded.calibration.size() != 3 || !std::isnan(reloaded.calibration[1]) || !std::isnan(reloaded.zoom)) {
+		std::cout << "The preferences were not loaded as they were saved" << std::endl;
+		return 1;
+	}
+	size_t savedMemory = QuickPreferences::memoryUsage(*QuickPreferences::parseJSON("prefs.json")).total();
+	if (QuickPreferences::lastPeakMemory().total() < savedMemory) {
+		std::cout << "Saving used " << QuickPreferences::lastPeakMemory().total() << " bytes at most, less than the " << savedMemory
+				<< " bytes of its structure" << std::endl;
+		return 1;
+	}
+	Preferences loadedAsync;
+	QuickPreferences::ParsedFile parsed = QuickPreferences::loadAsync("prefs.json").get();
+	if (!parsed.valid() || !parsed.applyTo(loadedAsync) || loadedAsync.serialise() != reloaded.serialise()) {
+		std::cout << "Loading in the background gave a different result" << std::endl;
+		return 1;
+	}
+
+	try {
+		Preferences hostile;
+		hostile.deserialise("{\"appendices\": {\"count\": 1e12, \"columns\": {}}}");
+		std::cout << "A columnar vector with more elements than its columns was accepted" << std::endl;
+		return 1;
+	} catch (std::runtime_error&) {}
+
+	Site site;
+	site.pages.resize(3);
+	site.about->author = "Webmaster";
+	site.save("site.json");
+	QuickPreferences::FileStamp siteStamp;
+	Site watched;
+	bool loadedFirst = watched.load("site.json", siteStamp);
+	bool loadedAgain = watched.load("site.json", siteStamp);
+	site.save("site.json");
+	bool loadedRewritten = watched.load("site.json", siteStamp);
+	if (!loadedFirst || loadedAgain || loadedRewritten || watched.pages.size() != 3) {
+		std::cout << "Loading only changed files doesn't work" << std::endl;
+		return 1;
+	}
+	Site tenant = site;
+	tenant.port = 8080;
+	tenant.deserialise("{\"about\": {\"contents\": \"Tenant's page\"}}");
+	if (site.about->contents != "" || tenant.about->author != "Webmaster") {
+		std::cout << "Loading a copy changed the original" << std::endl;
+		return 1;
+	}
+	tenant.save("tenant.json", site);
+	Site layered;
+	layered.load("site.json");
+	layered.load("tenant.json");
+	layered.deserialise("{\"port\": 8081}");
+	if (layered.port != 8081 || layered.pages.size() != 3 || !layered.about || layered.about->author != "Webmaster"
+			|| layered.about->contents != "Tenant's page") {
+		std::cout << "Loading the layers lost some values" << std::endl;
+		return 1;
+	}
 
 	return 0;
 }